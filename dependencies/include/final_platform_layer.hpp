@@ -647,6 +647,23 @@ namespace fpl {
 		fpl_api void ThreadWaitForSingle(const ThreadContext &context, const uint32_t maxMilliseconds = UINT32_MAX);
 		//! Wait until all given threads are done running.
 		fpl_api void ThreadWaitForMultiple(const ThreadContext *contexts, const uint32_t count, const uint32_t maxMilliseconds = UINT32_MAX);
+
+		//! Handle to a counting semaphore
+		struct SemaphoreHandle {
+			//! Internal semaphore handle
+			void *internalHandle;
+			//! Semaphore created successfully
+			bool isValid;
+		};
+
+		//! Creates a counting semaphore with the given initial count and returns the handle for it.
+		fpl_api SemaphoreHandle SemaphoreCreate(const uint32_t initialCount = 0);
+		//! Releases the given semaphore and resets the handle to zero.
+		fpl_api void SemaphoreDestroy(SemaphoreHandle &semaphore);
+		//! Waits until the count of the given semaphore is greater than zero and decrements it. Returns false when the wait timed out.
+		fpl_api bool SemaphoreWait(const SemaphoreHandle &semaphore, const uint32_t maxMilliseconds = UINT32_MAX);
+		//! Increments the count of the given semaphore by the given count, so that many waiting threads will wake up.
+		fpl_api void SemaphoreRelease(const SemaphoreHandle &semaphore, const uint32_t count = 1);
 	};
 
 	//! Memory allocation functions
@@ -1861,7 +1878,10 @@ namespace fpl {
 
 	namespace hardware {
 		fpl_api uint32_t GetProcessorCoreCount() {
-			uint32_t result = 0;
+			SYSTEM_INFO sysInfo = {};
+			GetSystemInfo(&sysInfo);
+			// @NOTE: For now this returns the number of logical processors, which is the actual value we mostly want
+			uint32_t result = sysInfo.dwNumberOfProcessors;
 			return(result);
 		}
 		fpl_api char *GetProcessorName(char *destBuffer, const uint32_t maxDestBufferLen) {
@@ -2141,6 +2161,39 @@ namespace fpl {
 			}
 			WaitForMultipleObjects(count, threadHandles, TRUE, maxMilliseconds < UINT32_MAX ? maxMilliseconds : INFINITE);
 		}
+
+		fpl_api SemaphoreHandle SemaphoreCreate(const uint32_t initialCount) {
+			SemaphoreHandle result = {};
+			HANDLE handle = CreateSemaphoreA(nullptr, (LONG)initialCount, MAXLONG, nullptr);
+			if (handle != nullptr) {
+				result.internalHandle = (void *)handle;
+				result.isValid = true;
+			}
+			return(result);
+		}
+
+		fpl_api void SemaphoreDestroy(SemaphoreHandle &semaphore) {
+			if (semaphore.internalHandle != nullptr) {
+				CloseHandle((HANDLE)semaphore.internalHandle);
+			}
+			semaphore = {};
+		}
+
+		fpl_api bool SemaphoreWait(const SemaphoreHandle &semaphore, const uint32_t maxMilliseconds) {
+			FPL_ASSERT(semaphore.internalHandle != nullptr);
+			HANDLE handle = (HANDLE)semaphore.internalHandle;
+			DWORD waitResult = WaitForSingleObject(handle, maxMilliseconds < UINT32_MAX ? maxMilliseconds : INFINITE);
+			bool result = waitResult == WAIT_OBJECT_0;
+			return(result);
+		}
+
+		fpl_api void SemaphoreRelease(const SemaphoreHandle &semaphore, const uint32_t count) {
+			FPL_ASSERT(semaphore.internalHandle != nullptr);
+			if (count > 0) {
+				HANDLE handle = (HANDLE)semaphore.internalHandle;
+				ReleaseSemaphore(handle, (LONG)count, nullptr);
+			}
+		}
 	}
 
 	//
@@ -66,6 +66,10 @@ SOFTWARE.
 	* Initial version
 - v1.01:
 	* Added additional C++ api
+- v1.02:
+	* Vertex lookup uses a open addressing hash table instead of a linear search
+	* Edge cancellation and traversal uses a edge hash table and per-vertex outgoing edges
+	* RunTileTracer traces the full map in one pass without going through the single steps
 
 */
 #ifndef FTT_INCLUDE_HPP
@@ -161,6 +165,21 @@ namespace ftt {
 		std::vector<Vec2i> vertices;
 	};
 
+	//! Hash entry, maps a 64-bit key to a index
+	struct HashEntry {
+		uint64_t key;
+		int32_t value;
+	};
+
+	//! Open addressing hash table with linear probing
+	struct HashTable {
+		std::vector<HashEntry> entries;
+		//! Number of live entries
+		uint32_t count;
+		//! Number of live and removed entries
+		uint32_t usedCount;
+	};
+
 	struct TileTracerData {
 		Vec2u tileCount;
 		std::vector<Tile> tiles;
@@ -172,9 +191,19 @@ namespace ftt {
 		Edge *lastEdge;
 		ChainSegment *curChainSegment;
 		std::vector<Tile *> openList;
+		//! Raster scan position for the next start tile, tiles before it are never solid again
+		uint32_t scanTileIndex;
 		std::vector<Vec2i> mainVertices;
 		std::vector<Edge> mainEdges;
 		std::vector<ChainSegment> chainSegments;
+		//! Lattice coordinate to main vertex index
+		HashTable vertexHash;
+		//! Vertex index pair to main edge index, for all edges which are not cancelled
+		HashTable edgeHash;
+		//! Outgoing edges for each vertex (vertexEdges[vertexEdgeOffsets[v]] to vertexEdges[vertexEdgeOffsets[v + 1]]), built before traversal starts
+		std::vector<uint32_t> vertexEdgeOffsets;
+		std::vector<uint32_t> vertexEdges;
+		uint32_t nextStartEdgeIndex;
 	};
 
 	//! Tile tracer C++ API
@@ -187,7 +216,7 @@ namespace ftt {
 
 		//! Executes the next step for the tracer
 		bool Next();
-		//! Runs the full tracer until it is done.
+		//! Runs the full tracer until it is done. Gives the same result as calling Next() until it returns false.
 		void Run();
 
 		//! Returns the number of chain segments
@@ -389,13 +418,13 @@ namespace ftt {
 			SetTileSolid(tiles, dimension, x, y, -1);
 		}
 
-		static Tile *GetFirstSolidTile(std::vector<Tile> &tiles, const Vec2u &dimension) {
-			for (uint32_t tileY = 0; tileY < dimension.h; ++tileY) {
-				for (uint32_t tileX = 0; tileX < dimension.w; ++tileX) {
-					if (IsTileSolid(tiles, dimension, tileX, tileY)) {
-						Tile *tile = GetTile(tiles, dimension, tileX, tileY);
-						return tile;
-					}
+		// Tiles are only removed and never added, so the raster scan can continue where the last one has stopped
+		static Tile *GetFirstSolidTile(std::vector<Tile> &tiles, const Vec2u &dimension, uint32_t &scanTileIndex) {
+			uint32_t tileCount = dimension.w * dimension.h;
+			for (; scanTileIndex < tileCount; ++scanTileIndex) {
+				Tile *tile = &tiles[scanTileIndex];
+				if (tile->isSolid > 0) {
+					return tile;
 				}
 			}
 			return nullptr;
@@ -410,25 +439,122 @@ namespace ftt {
 			return(result);
 		}
 
+		// Minimum number of entries in a hash table, must be a power of two
+		static const uint32_t TILETRACE_MIN_HASH_CAPACITY = 1024;
+
+		// Special hash entry values
+		static const int32_t HASH_EMPTY = -1;
+		static const int32_t HASH_REMOVED = -2;
+
+		inline uint64_t ComputeEdgeHash(int32_t vertIndex0, int32_t vertIndex1) {
+			uint64_t result = ((uint64_t)(uint32_t)vertIndex0 << 32) | (uint64_t)(uint32_t)vertIndex1;
+			return(result);
+		}
+
+		inline uint32_t GetHashSlot(const HashTable &table, const uint64_t key) {
+			// Fibonacci hashing, so neighbouring coordinates are spread across the table
+			uint64_t hash = key * 11400714819323198485ULL;
+			uint32_t result = (uint32_t)(hash >> 32) & (uint32_t)(table.entries.size() - 1);
+			return(result);
+		}
+
+		static void InitHashTable(HashTable &table, const uint32_t capacity) {
+			assert((capacity & (capacity - 1)) == 0);
+			HashEntry emptyEntry = {};
+			emptyEntry.value = HASH_EMPTY;
+			table.entries.assign(capacity, emptyEntry);
+			table.count = 0;
+			table.usedCount = 0;
+		}
+
+		static int32_t HashFind(const HashTable &table, const uint64_t key) {
+			uint32_t mask = (uint32_t)(table.entries.size() - 1);
+			uint32_t slot = GetHashSlot(table, key);
+			while (table.entries[slot].value != HASH_EMPTY) {
+				if (table.entries[slot].value != HASH_REMOVED && table.entries[slot].key == key) {
+					return table.entries[slot].value;
+				}
+				slot = (slot + 1) & mask;
+			}
+			return HASH_EMPTY;
+		}
+
+		static void HashInsert(HashTable &table, const uint64_t key, const int32_t value);
+
+		static void RehashTable(HashTable &table) {
+			// Removed entries are dropped, the capacity only grows when the live entries needs it
+			uint32_t capacity = (uint32_t)table.entries.size();
+			if ((uint64_t)(table.count + 1) * 10 > (uint64_t)capacity * 5) {
+				capacity *= 2;
+			}
+			std::vector<HashEntry> oldEntries;
+			oldEntries.swap(table.entries);
+			InitHashTable(table, capacity);
+			for (size_t entryIndex = 0; entryIndex < oldEntries.size(); ++entryIndex) {
+				const HashEntry &entry = oldEntries[entryIndex];
+				if (entry.value >= 0) {
+					HashInsert(table, entry.key, entry.value);
+				}
+			}
+		}
+
+		// Key must not be in the table already
+		static void HashInsert(HashTable &table, const uint64_t key, const int32_t value) {
+			assert(value >= 0);
+			// Keep the load factor below 70%, so the probe sequences stays short
+			if ((uint64_t)(table.usedCount + 1) * 10 > (uint64_t)table.entries.size() * 7) {
+				RehashTable(table);
+			}
+			uint32_t mask = (uint32_t)(table.entries.size() - 1);
+			uint32_t slot = GetHashSlot(table, key);
+			while (table.entries[slot].value >= 0) {
+				slot = (slot + 1) & mask;
+			}
+			if (table.entries[slot].value == HASH_EMPTY) {
+				++table.usedCount;
+			}
+			table.entries[slot].key = key;
+			table.entries[slot].value = value;
+			++table.count;
+		}
+
+		static bool HashRemove(HashTable &table, const uint64_t key) {
+			uint32_t mask = (uint32_t)(table.entries.size() - 1);
+			uint32_t slot = GetHashSlot(table, key);
+			while (table.entries[slot].value != HASH_EMPTY) {
+				if (table.entries[slot].value != HASH_REMOVED && table.entries[slot].key == key) {
+					table.entries[slot].value = HASH_REMOVED;
+					--table.count;
+					return true;
+				}
+				slot = (slot + 1) & mask;
+			}
+			return false;
+		}
+
+		static int32_t FindVertex(TileTracerData *traceState, const Vec2i &vertex) {
+			uint64_t key = ComputeTileHash((uint32_t)vertex.x, (uint32_t)vertex.y);
+			int32_t result = HashFind(traceState->vertexHash, key);
+			return(result);
+		}
+
+		static int32_t FindOrAddVertex(TileTracerData *traceState, const Vec2i &vertex) {
+			uint64_t key = ComputeTileHash((uint32_t)vertex.x, (uint32_t)vertex.y);
+			int32_t result = HashFind(traceState->vertexHash, key);
+			if (result == HASH_EMPTY) {
+				result = (int32_t)traceState->mainVertices.size();
+				traceState->mainVertices.push_back(vertex);
+				HashInsert(traceState->vertexHash, key, result);
+			}
+			return(result);
+		}
+
 		static TileIndices PushTileVertices(TileTracerData *traceState, Tile *tile) {
 			TileIndices result = {};
 			TileVertices tileVerts = CreateTileVertices(tile);
 			assert(ArrayCount(tileVerts.verts) == ArrayCount(result.indices));
 			for (uint32_t vertIndex = 0; vertIndex < ArrayCount(tileVerts.verts); ++vertIndex) {
-				Vec2i vertex = tileVerts.verts[vertIndex];
-				int32_t matchedMainVertexIndex = -1;
-				for (uint32_t mainVertexIndex = 0; mainVertexIndex < traceState->mainVertices.size(); ++mainVertexIndex) {
-					if (IsEqual(traceState->mainVertices[mainVertexIndex], vertex)) {
-						matchedMainVertexIndex = mainVertexIndex;
-						break;
-					}
-				}
-				if (matchedMainVertexIndex == -1) {
-					result.indices[vertIndex] = (int32_t)traceState->mainVertices.size();
-					traceState->mainVertices.push_back(vertex);
-				} else {
-					result.indices[vertIndex] = matchedMainVertexIndex;
-				}
+				result.indices[vertIndex] = FindOrAddVertex(traceState, tileVerts.verts[vertIndex]);
 			}
 			return(result);
 		}
@@ -448,16 +574,14 @@ namespace ftt {
 			TileEdges result = {};
 			for (uint32_t edgeIndex = 0; edgeIndex < inputEdges.count; ++edgeIndex) {
 				Edge inputEdge = inputEdges.edges[edgeIndex];
-				bool addIt = true;
-				for (uint32_t mainEdgeIndex = 0; mainEdgeIndex < traceState->mainEdges.size(); ++mainEdgeIndex) {
-					Edge mainEdge = traceState->mainEdges[mainEdgeIndex];
-					if (inputEdge.vertIndex0 == mainEdge.vertIndex1 && inputEdge.vertIndex1 == mainEdge.vertIndex0) {
-						addIt = false;
-						traceState->mainEdges.erase(traceState->mainEdges.begin() + mainEdgeIndex);
-						break;
-					}
-				}
-				if (addIt) {
+				// A overlapping edge is the same edge in the opposite direction
+				uint64_t overlapKey = ComputeEdgeHash(inputEdge.vertIndex1, inputEdge.vertIndex0);
+				int32_t mainEdgeIndex = HashFind(traceState->edgeHash, overlapKey);
+				if (mainEdgeIndex != HASH_EMPTY) {
+					// Cancelled edges stays in the main edges as invalid, until the traversal starts
+					HashRemove(traceState->edgeHash, overlapKey);
+					traceState->mainEdges[mainEdgeIndex].isInvalid = true;
+				} else {
 					result.edges[result.count++] = inputEdge;
 				}
 			}
@@ -466,14 +590,16 @@ namespace ftt {
 
 		static bool IsTileSharesCommonEdges(TileTracerData *traceState, TileVertices tileVertices) {
 			uint32_t vertexCount = (uint32_t)ArrayCount(tileVertices.verts);
+			int32_t vertIndices[4];
+			assert(ArrayCount(vertIndices) == vertexCount);
+			for (uint32_t vertIndex = 0; vertIndex < vertexCount; ++vertIndex) {
+				vertIndices[vertIndex] = FindVertex(traceState, tileVertices.verts[vertIndex]);
+			}
 			for (uint32_t vertIndex = 0; vertIndex < vertexCount; ++vertIndex) {
-				Vec2i tv0 = tileVertices.verts[vertIndex];
-				Vec2i tv1 = tileVertices.verts[(vertIndex + 1) % vertexCount];
-				for (uint32_t edgeIndex = 0; edgeIndex < traceState->mainEdges.size(); ++edgeIndex) {
-					Edge edge = traceState->mainEdges[edgeIndex];
-					Vec2i mv0 = traceState->mainVertices[edge.vertIndex0];
-					Vec2i mv1 = traceState->mainVertices[edge.vertIndex1];
-					if (IsEqual(tv0, mv1) && IsEqual(tv1, mv0)) {
+				int32_t v0 = vertIndices[vertIndex];
+				int32_t v1 = vertIndices[(vertIndex + 1) % vertexCount];
+				if (v0 != HASH_EMPTY && v1 != HASH_EMPTY) {
+					if (HashFind(traceState->edgeHash, ComputeEdgeHash(v1, v0)) != HASH_EMPTY) {
 						return true;
 					}
 				}
@@ -481,6 +607,34 @@ namespace ftt {
 			return false;
 		}
 
+		static void BuildEdgeTraversal(TileTracerData *traceState) {
+			// Drop all cancelled edges, but keep the order of the others
+			uint32_t edgeCount = 0;
+			for (uint32_t mainEdgeIndex = 0; mainEdgeIndex < traceState->mainEdges.size(); ++mainEdgeIndex) {
+				if (!traceState->mainEdges[mainEdgeIndex].isInvalid) {
+					traceState->mainEdges[edgeCount++] = traceState->mainEdges[mainEdgeIndex];
+				}
+			}
+			traceState->mainEdges.resize(edgeCount);
+
+			// Outgoing edges for each vertex, in the same order as the main edges
+			uint32_t vertexCount = (uint32_t)traceState->mainVertices.size();
+			traceState->vertexEdgeOffsets.assign(vertexCount + 1, 0);
+			traceState->vertexEdges.resize(edgeCount);
+			for (uint32_t mainEdgeIndex = 0; mainEdgeIndex < edgeCount; ++mainEdgeIndex) {
+				++traceState->vertexEdgeOffsets[traceState->mainEdges[mainEdgeIndex].vertIndex0 + 1];
+			}
+			for (uint32_t vertIndex = 0; vertIndex < vertexCount; ++vertIndex) {
+				traceState->vertexEdgeOffsets[vertIndex + 1] += traceState->vertexEdgeOffsets[vertIndex];
+			}
+			std::vector<uint32_t> insertOffsets(traceState->vertexEdgeOffsets.begin(), traceState->vertexEdgeOffsets.end() - 1);
+			for (uint32_t mainEdgeIndex = 0; mainEdgeIndex < edgeCount; ++mainEdgeIndex) {
+				int32_t vertIndex0 = traceState->mainEdges[mainEdgeIndex].vertIndex0;
+				traceState->vertexEdges[insertOffsets[vertIndex0]++] = mainEdgeIndex;
+			}
+			traceState->nextStartEdgeIndex = 0;
+		}
+
 		inline void RemoveSegmentVertex(ChainSegment *chainSegment, uint32_t index) {
 			assert(index < chainSegment->vertices.size());
 			chainSegment->vertices.erase(chainSegment->vertices.begin() + index);
@@ -519,9 +673,13 @@ namespace ftt {
 		}
 
 		static bool ProcessTraverseNextEdge(TileTracerData *traceState) {
-			for (uint32_t mainEdgeIndex = 0; mainEdgeIndex < traceState->mainEdges.size(); ++mainEdgeIndex) {
-				Edge *curEdge = &traceState->mainEdges[mainEdgeIndex];
-				if (!curEdge->isInvalid && (curEdge->vertIndex0 == traceState->lastEdge->vertIndex1)) {
+			// Only the outgoing edges from the end of the last edge can continue the chain
+			int32_t lastVertIndex = traceState->lastEdge->vertIndex1;
+			uint32_t firstOutgoingIndex = traceState->vertexEdgeOffsets[lastVertIndex];
+			uint32_t lastOutgoingIndex = traceState->vertexEdgeOffsets[lastVertIndex + 1];
+			for (uint32_t outgoingIndex = firstOutgoingIndex; outgoingIndex < lastOutgoingIndex; ++outgoingIndex) {
+				Edge *curEdge = &traceState->mainEdges[traceState->vertexEdges[outgoingIndex]];
+				if (!curEdge->isInvalid) {
 					// If v0 from current edge equals starting edge - then we are finished
 					if (curEdge->vertIndex1 == traceState->startEdge->vertIndex0) {
 						// We are done with this line segment - Set cur step to find next starting edge
@@ -566,12 +724,13 @@ namespace ftt {
 			bool result = false;
 
 			// Find next free starting edge - at the start this is always null
+			// Edges never gets valid again, so the search continues where the last one has stopped
 			traceState->startEdge = nullptr;
 			int32_t startEdgeIndex = -1;
-			for (uint32_t mainEdgeIndex = 0; mainEdgeIndex < traceState->mainEdges.size(); ++mainEdgeIndex) {
-				Edge *mainEdge = &traceState->mainEdges[mainEdgeIndex];
+			for (; traceState->nextStartEdgeIndex < traceState->mainEdges.size(); ++traceState->nextStartEdgeIndex) {
+				Edge *mainEdge = &traceState->mainEdges[traceState->nextStartEdgeIndex];
 				if (!mainEdge->isInvalid) {
-					startEdgeIndex = mainEdgeIndex;
+					startEdgeIndex = traceState->nextStartEdgeIndex;
 					traceState->startEdge = mainEdge;
 					break;
 				}
@@ -629,7 +788,9 @@ namespace ftt {
 
 			// Push the remaining edges to the main edges list
 			for (uint32_t tileEdgeIndex = 0; tileEdgeIndex < tileEdges.count; ++tileEdgeIndex) {
-				traceState->mainEdges.push_back(tileEdges.edges[tileEdgeIndex]);
+				const Edge &tileEdge = tileEdges.edges[tileEdgeIndex];
+				HashInsert(traceState->edgeHash, ComputeEdgeHash(tileEdge.vertIndex0, tileEdge.vertIndex1), (int32_t)traceState->mainEdges.size());
+				traceState->mainEdges.push_back(tileEdge);
 			}
 		}
 	};
@@ -642,17 +803,33 @@ namespace ftt {
 
 		tracer->tileCount = tileCount;
 		tracer->tiles.resize(tileCount.x  * tileCount.y);
+		uint32_t solidTileCount = 0;
 		for (uint32_t tileY = 0; tileY < tileCount.h; ++tileY) {
 			for (uint32_t tileX = 0; tileX < tileCount.w; ++tileX) {
 				uint32_t tileIndex = ComputeTileIndex(tileCount, tileX, tileY);
 				int32_t isSolid = mapTiles[tileIndex];
 				Tile *tile = &tracer->tiles[tileIndex];
 				*tile = MakeTile(tileX, tileY, isSolid);
+				if (isSolid > 0) {
+					++solidTileCount;
+				}
 			}
 		}
 
+		// Most vertices are shared between tiles, so start with roughly two entries per solid tile and grow when needed
+		uint32_t vertexHashCapacity = TILETRACE_MIN_HASH_CAPACITY;
+		while (vertexHashCapacity < solidTileCount * 2) {
+			vertexHashCapacity *= 2;
+		}
+		InitHashTable(tracer->vertexHash, vertexHashCapacity);
+		InitHashTable(tracer->edgeHash, vertexHashCapacity);
+		tracer->vertexEdgeOffsets.clear();
+		tracer->vertexEdges.clear();
+		tracer->nextStartEdgeIndex = 0;
+
 		tracer->curStep = Step::FindStart;
 		tracer->openList.clear();
+		tracer->scanTileIndex = 0;
 		tracer->startTile = nullptr;
 		tracer->mainVertices.clear();
 		tracer->mainEdges.clear();
@@ -685,7 +862,7 @@ namespace ftt {
 			{
 				tracer->openList.clear();
 				tracer->curTile = nullptr;
-				tracer->startTile = GetFirstSolidTile(tracer->tiles, tracer->tileCount);
+				tracer->startTile = GetFirstSolidTile(tracer->tiles, tracer->tileCount, tracer->scanTileIndex);
 				if (tracer->startTile != nullptr) {
 					// Add the start tile to the open list and build vertices and edges from it
 					AddTile(tracer, tracer->startTile);
@@ -700,6 +877,7 @@ namespace ftt {
 					} else {
 						// Clear all chain segments
 						tracer->chainSegments.clear();
+						BuildEdgeTraversal(tracer);
 						tracer->curStep = Step::TraverseFindStartingEdge;
 					}
 				}
@@ -749,8 +927,48 @@ namespace ftt {
 
 	ftt_api void RunTileTracer(TileTracerData *tracer) {
 		assert(tracer != nullptr);
-		while (NextTileTraceStep(tracer)) {
+		assert(tracer->curStep == Step::FindStart);
+
+		using namespace internals;
+
+		// Flood fill every connected group of solid tiles, starting from the first solid tile in raster order
+		for (;;) {
+			tracer->startTile = GetFirstSolidTile(tracer->tiles, tracer->tileCount, tracer->scanTileIndex);
+			if (tracer->startTile == nullptr) {
+				break;
+			}
+			AddTile(tracer, tracer->startTile);
+
+			// Same visiting order as the FindNextTile/RotateForward steps, so we get the exact same edges.
+			// The shared edge test is skipped, a solid neighbour of a added tile always shares the edge between them.
+			while (tracer->openList.size() > 0) {
+				Tile *curTile = tracer->openList[tracer->openList.size() - 1];
+				int32_t nx = curTile->x + TILETRACE_DIRECTIONS[curTile->traceDirection].x;
+				int32_t ny = curTile->y + TILETRACE_DIRECTIONS[curTile->traceDirection].y;
+				if (IsTileSolid(tracer->tiles, tracer->tileCount, nx, ny)) {
+					AddTile(tracer, GetTile(tracer->tiles, tracer->tileCount, nx, ny));
+				} else if (curTile->traceDirection < (TILETRACE_DIRECTION_COUNT - 1)) {
+					++curTile->traceDirection;
+				} else {
+					tracer->openList.pop_back();
+				}
+			}
+		}
+		tracer->curTile = nullptr;
+		tracer->nextTile = nullptr;
+
+		// Extract all contours from the remaining edges
+		tracer->chainSegments.clear();
+		if (tracer->mainEdges.size() > 0) {
+			BuildEdgeTraversal(tracer);
+			tracer->curStep = Step::TraverseFindStartingEdge;
+			while (ProcessTraverseFindStartingEdge(tracer)) {
+				while (tracer->curStep == Step::TraverseNextEdge) {
+					ProcessTraverseNextEdge(tracer);
+				}
+			}
 		}
+		tracer->curStep = Step::Done;
 	}
 
 	TileTracer::TileTracer(const Vec2u &tileCount, uint8_t *mapTiles) {
@@ -29,6 +29,75 @@ namespace fs {
 			}
 		}
 
+		extern GridTraversal2D BeginGridTraversal(const Vec2f &start, const Vec2f &end, const Vec2f &gridOrigin, const f32 cellSize) {
+			assert(cellSize > 0.0f);
+			GridTraversal2D result = {};
+
+			// Everything is computed in cell units, so t is always in range of 0 to 1
+			f32 invCellSize = 1.0f / cellSize;
+			Vec2f a = (start - gridOrigin) * invCellSize;
+			Vec2f b = (end - gridOrigin) * invCellSize;
+			Vec2f delta = b - a;
+
+			result.cell = Vec2i((s32)floorf(a.x), (s32)floorf(a.y));
+			result.endCell = Vec2i((s32)floorf(b.x), (s32)floorf(b.y));
+			result.step = Vec2i(delta.x > 0 ? 1 : (delta.x < 0 ? -1 : 0), delta.y > 0 ? 1 : (delta.y < 0 ? -1 : 0));
+			result.tDelta.x = result.step.x != 0 ? 1.0f / Absolute(delta.x) : F32_MAX;
+			result.tDelta.y = result.step.y != 0 ? 1.0f / Absolute(delta.y) : F32_MAX;
+			if (result.step.x > 0) {
+				result.tMax.x = ((f32)(result.cell.x + 1) - a.x) * result.tDelta.x;
+			} else if (result.step.x < 0) {
+				result.tMax.x = (a.x - (f32)result.cell.x) * result.tDelta.x;
+			} else {
+				result.tMax.x = F32_MAX;
+			}
+			if (result.step.y > 0) {
+				result.tMax.y = ((f32)(result.cell.y + 1) - a.y) * result.tDelta.y;
+			} else if (result.step.y < 0) {
+				result.tMax.y = (a.y - (f32)result.cell.y) * result.tDelta.y;
+			} else {
+				result.tMax.y = F32_MAX;
+			}
+			return(result);
+		}
+
+		extern bool NextGridCell(GridTraversal2D &traversal, Vec2i &outCell) {
+			if (traversal.pendingCount > 0) {
+				outCell = traversal.pendingCells[--traversal.pendingCount];
+				return true;
+			}
+			if (traversal.isFinished) {
+				return false;
+			}
+
+			outCell = traversal.cell;
+
+			if ((traversal.cell.x == traversal.endCell.x && traversal.cell.y == traversal.endCell.y) || (traversal.tMax.x > 1.0f && traversal.tMax.y > 1.0f)) {
+				traversal.isFinished = true;
+				return true;
+			}
+
+			// @NOTE: Crossings which are nearly at the same time are treated as a corner crossing,
+			// so we never miss a cell the segment is just grazing due to floating point precision.
+			constexpr f32 CornerEpsilon = 1e-4f;
+			if (traversal.tMax.x < traversal.tMax.y - CornerEpsilon) {
+				traversal.cell.x += traversal.step.x;
+				traversal.tMax.x += traversal.tDelta.x;
+			} else if (traversal.tMax.y < traversal.tMax.x - CornerEpsilon) {
+				traversal.cell.y += traversal.step.y;
+				traversal.tMax.y += traversal.tDelta.y;
+			} else {
+				traversal.pendingCells[0] = Vec2i(traversal.cell.x, traversal.cell.y + traversal.step.y);
+				traversal.pendingCells[1] = Vec2i(traversal.cell.x + traversal.step.x, traversal.cell.y);
+				traversal.pendingCount = 2;
+				traversal.cell.x += traversal.step.x;
+				traversal.cell.y += traversal.step.y;
+				traversal.tMax.x += traversal.tDelta.x;
+				traversal.tMax.y += traversal.tDelta.y;
+			}
+			return true;
+		}
+
 		extern IntersectionResult IntersectLines(const f32 tmin, const f32 epsilon, const u32 planeCount, const DeltaPlane2D *planes) {
 			IntersectionResult result = {};
 			result.tMin = tmin;
@@ -49,6 +118,59 @@ namespace fs {
 			return(result);
 		}
 
+		extern IntersectionResult IntersectLinesx4(const f32 tmin, const f32 epsilon, const DeltaPlane2Dx4 &planes) {
+			// Compute the intersection time and the hit state for all four planes at once
+			__declspec(align(16)) f32 times[4];
+			s32 hitMask = 0;
+#if MATH_ENABLE_SSE2
+			__m128 plane = _mm_load_ps(planes.plane);
+			__m128 relX = _mm_load_ps(planes.relX);
+			__m128 relY = _mm_load_ps(planes.relY);
+			__m128 deltaX = _mm_load_ps(planes.deltaX);
+			__m128 deltaY = _mm_load_ps(planes.deltaY);
+			__m128 minY = _mm_load_ps(planes.minY);
+			__m128 maxY = _mm_load_ps(planes.maxY);
+			__m128 zero = _mm_setzero_ps();
+
+			// @NOTE: Planes with a zero delta produces inf/nan here, but these are masked out below
+			__m128 f = _mm_div_ps(_mm_sub_ps(plane, relX), deltaX);
+			__m128 y = _mm_add_ps(relY, _mm_mul_ps(f, deltaY));
+
+			__m128 mask = _mm_cmpneq_ps(deltaX, zero);
+			mask = _mm_and_ps(mask, _mm_cmpge_ps(f, zero));
+			mask = _mm_and_ps(mask, _mm_cmpge_ps(y, minY));
+			mask = _mm_and_ps(mask, _mm_cmple_ps(y, maxY));
+
+			_mm_store_ps(times, f);
+			hitMask = _mm_movemask_ps(mask);
+#else
+			for (u32 planeIndex = 0; planeIndex < 4; ++planeIndex) {
+				times[planeIndex] = 0.0f;
+				if (planes.deltaX[planeIndex] != 0.0f) {
+					f32 f = (planes.plane[planeIndex] - planes.relX[planeIndex]) / planes.deltaX[planeIndex];
+					f32 y = planes.relY[planeIndex] + f*planes.deltaY[planeIndex];
+					times[planeIndex] = f;
+					if ((f >= 0.0f) && (y >= planes.minY[planeIndex]) && (y <= planes.maxY[planeIndex])) {
+						hitMask |= 1 << planeIndex;
+					}
+				}
+			}
+#endif
+
+			// @NOTE: The selection must stay sequential: An accepted plane lowers tMin by the epsilon,
+			// which affects the following planes - a plain minimum would not give the same result as IntersectLines()
+			IntersectionResult result = {};
+			result.tMin = tmin;
+			for (u32 planeIndex = 0; planeIndex < 4; ++planeIndex) {
+				if ((hitMask & (1 << planeIndex)) && (result.tMin > times[planeIndex])) {
+					result.tMin = Maximum(0.0f, times[planeIndex] - epsilon);
+					result.normal = planes.normal[planeIndex];
+					result.wasHit = true;
+				}
+			}
+			return(result);
+		}
+
 		extern LineCastResult LineCastQuad(const Ray2D &ray, const Quad &quad) {
 			LineCastResult result = {};
 			result.tMin = ray.tMin;
@@ -58,14 +180,13 @@ namespace fs {
 			Vec2f minCorner = -quad.ext;
 			Vec2f maxCorner = quad.ext;
 
-			DeltaPlane2D testSides[4];
-			u32 sideCount = 0;
-			testSides[sideCount++] = { minCorner.x, rel.x, rel.y, delta.x, delta.y, minCorner.y, maxCorner.y,{ -1, 0 } };
-			testSides[sideCount++] = { maxCorner.x, rel.x, rel.y, delta.x, delta.y, minCorner.y, maxCorner.y,{ 1, 0 } };
-			testSides[sideCount++] = { minCorner.y, rel.y, rel.x, delta.y, delta.x, minCorner.x, maxCorner.x,{ 0, -1 } };
-			testSides[sideCount++] = { maxCorner.y, rel.y, rel.x, delta.y, delta.x, minCorner.x, maxCorner.x,{ 0, 1 } };
+			DeltaPlane2Dx4 testSides = {};
+			testSides.Set(0, { minCorner.x, rel.x, rel.y, delta.x, delta.y, minCorner.y, maxCorner.y,{ -1, 0 } });
+			testSides.Set(1, { maxCorner.x, rel.x, rel.y, delta.x, delta.y, minCorner.y, maxCorner.y,{ 1, 0 } });
+			testSides.Set(2, { minCorner.y, rel.y, rel.x, delta.y, delta.x, minCorner.x, maxCorner.x,{ 0, -1 } });
+			testSides.Set(3, { maxCorner.y, rel.y, rel.x, delta.y, delta.x, minCorner.x, maxCorner.x,{ 0, 1 } });
 
-			IntersectionResult intersectionResult = IntersectLines(ray.tMin, 0.0f, sideCount, testSides);
+			IntersectionResult intersectionResult = IntersectLinesx4(ray.tMin, 0.0f, testSides);
 			if (intersectionResult.wasHit && intersectionResult.tMin < result.tMin) {
 				result.isHit = true;
 				result.tMin = intersectionResult.tMin;
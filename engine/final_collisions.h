@@ -53,13 +53,56 @@ namespace fs {
 			Vec2f normal;
 		};
 
+		// @NOTE: Four planes in SoA layout, so all sides of a quad can be tested at once.
+		// Unused planes must have a delta x of zero, these are skipped just like in IntersectLines().
+		__declspec(align(16)) struct DeltaPlane2Dx4 {
+			f32 plane[4];
+			f32 relX[4];
+			f32 relY[4];
+			f32 deltaX[4];
+			f32 deltaY[4];
+			f32 minY[4];
+			f32 maxY[4];
+			Vec2f normal[4];
+
+			inline void Set(const u32 index, const DeltaPlane2D &source) {
+				assert(index < 4);
+				plane[index] = source.plane;
+				relX[index] = source.relX;
+				relY[index] = source.relY;
+				deltaX[index] = source.deltaX;
+				deltaY[index] = source.deltaY;
+				minY[index] = source.minY;
+				maxY[index] = source.maxY;
+				normal[index] = source.normal;
+			}
+		};
+
 		struct IntersectionResult {
 			Vec2f normal;
 			f32 tMin;
 			b32 wasHit;
 		};
 
+		// Grid traversal (Amanatides & Woo) which visits every cell touched by a line segment, ordered along the segment.
+		// @NOTE: When the segment crosses a cell corner, both neighbour cells are visited as well before the diagonal cell.
+		struct GridTraversal2D {
+			Vec2i cell;
+			Vec2i endCell;
+			Vec2i step;
+			Vec2f tMax;
+			Vec2f tDelta;
+			Vec2i pendingCells[2];
+			u32 pendingCount;
+			b32 isFinished;
+		};
+
+		extern GridTraversal2D BeginGridTraversal(const Vec2f &start, const Vec2f &end, const Vec2f &gridOrigin, const f32 cellSize);
+		extern bool NextGridCell(GridTraversal2D &traversal, Vec2i &outCell);
+
 		extern IntersectionResult IntersectLines(const f32 tmin, const f32 epsilon, const u32 planeCount, const DeltaPlane2D *planes);
+		// Same as IntersectLines() for exactly four planes, returns the exact same result
+		extern IntersectionResult IntersectLinesx4(const f32 tmin, const f32 epsilon, const DeltaPlane2Dx4 &planes);
 
 		extern void BresenhamLine(s32 x0, s32 y0, s32 x1, s32 y1, f32 width, std::vector<Vec2i> &out);
 
@@ -0,0 +1,502 @@
+#include "final_concurrency.h"
+
+#include <xmmintrin.h>
+#include <deque>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+#include "final_maths.h"
+#include "final_utils.h"
+
+using namespace fpl;
+
+namespace fs {
+	namespace concurrency {
+		// Number of pause spins before an idle worker sleeps on the wake semaphore
+		constexpr u32 WORKER_SPIN_COUNT = 4096;
+		constexpr u32 JOB_QUEUE_MASK = JOB_QUEUE_CAPACITY - 1;
+		static_assert((JOB_QUEUE_CAPACITY & JOB_QUEUE_MASK) == 0, "Job queue capacity must be a power of two");
+
+		// Queue of the calling thread, threads which are not a worker of the pool use the shared queue
+		static thread_local const WorkerPool *currentPool = nullptr;
+		static thread_local u32 currentQueueIndex = 0;
+
+		WorkerPool::WorkerPool() :
+			threadCount(0),
+			isShutdown(0),
+			queueMemory({}),
+			queues(nullptr),
+			queueCount(0),
+			sharedQueueLock({}),
+			wakeSemaphore({}),
+			sleepingWorkerCount(0) {
+		}
+
+		WorkerPool::~WorkerPool() {
+			assert(threadCount == 0);
+			assert(queues == nullptr);
+		}
+
+		bool WorkerPool::PushJob(const u32 queueIndex, const Job &job) {
+			JobQueue *queue = queues + queueIndex;
+			u32 bottom = AtomicReadU32(&queue->bottom);
+			u32 top = AtomicReadU32(&queue->top);
+			if ((bottom - top) >= JOB_QUEUE_CAPACITY) {
+				return false;
+			}
+			queue->jobs[bottom & JOB_QUEUE_MASK] = job;
+			// @NOTE: The job must be visible before the new bottom, otherwise a thief may steal a half written job
+			atomics::AtomicWriteFence();
+			atomics::AtomicExchangeU32(&queue->bottom, bottom + 1);
+			return true;
+		}
+
+		bool WorkerPool::PopJob(const u32 queueIndex, Job &outJob) {
+			JobQueue *queue = queues + queueIndex;
+			u32 bottom = AtomicReadU32(&queue->bottom) - 1;
+			// @NOTE: The exchange is a full barrier, the new bottom must be visible before top is read - otherwise the owner and a thief can take the same job
+			atomics::AtomicExchangeU32(&queue->bottom, bottom);
+			u32 top = AtomicReadU32(&queue->top);
+			s32 size = (s32)(bottom - top);
+			if (size < 0) {
+				// Queue is empty
+				atomics::AtomicExchangeU32(&queue->bottom, top);
+				return false;
+			}
+			outJob = queue->jobs[bottom & JOB_QUEUE_MASK];
+			if (size > 0) {
+				return true;
+			}
+			// Last job in the queue, race against the thieves
+			bool result = atomics::AtomicCompareExchangeU32(&queue->top, top + 1, top) == top;
+			atomics::AtomicExchangeU32(&queue->bottom, top + 1);
+			return(result);
+		}
+
+		bool WorkerPool::StealJob(const u32 queueIndex, Job &outJob) {
+			JobQueue *queue = queues + queueIndex;
+			u32 top = AtomicReadU32(&queue->top);
+			u32 bottom = AtomicReadU32(&queue->bottom);
+			if ((s32)(bottom - top) <= 0) {
+				return false;
+			}
+			// @NOTE: The job may be overwritten by the owner while we copy it, but then top was changed and the exchange fails
+			outJob = queue->jobs[top & JOB_QUEUE_MASK];
+			bool result = atomics::AtomicCompareExchangeU32(&queue->top, top + 1, top) == top;
+			return(result);
+		}
+
+		bool WorkerPool::GetNextJob(const u32 queueIndex, Job &outJob) {
+			bool result;
+			if (queueIndex == 0) {
+				sharedQueueLock.Lock();
+				result = PopJob(0, outJob);
+				sharedQueueLock.Unlock();
+			} else {
+				result = PopJob(queueIndex, outJob);
+			}
+			if (result) {
+				return true;
+			}
+			// @NOTE: Start with the next queue, so not every thread steals from the same queue
+			for (u32 offset = 1; offset < queueCount; ++offset) {
+				u32 stealIndex = (queueIndex + offset) % queueCount;
+				if (StealJob(stealIndex, outJob)) {
+					return true;
+				}
+			}
+			return false;
+		}
+
+		void WorkerPool::ExecuteJob(const Job &job) {
+			job.function(job.userData);
+			if (job.counter != nullptr) {
+				atomics::AtomicAddU32(&job.counter->pendingCount, (u32)-1);
+			}
+		}
+
+		void WorkerPool::WorkerThreadProc(const threading::ThreadContext &context, void *data) {
+			WorkerThread *worker = (WorkerThread *)data;
+			WorkerPool *pool = worker->pool;
+			currentPool = pool;
+			currentQueueIndex = worker->queueIndex;
+			u32 idleCount = 0;
+			while (!AtomicReadU32(&pool->isShutdown)) {
+				Job job;
+				if (pool->GetNextJob(worker->queueIndex, job)) {
+					ExecuteJob(job);
+					idleCount = 0;
+				} else if (idleCount < WORKER_SPIN_COUNT) {
+					_mm_pause();
+					++idleCount;
+				} else {
+					// @NOTE: The worker is counted as sleeping before it looks for jobs one last time.
+					// RunJobs() reads the count after it has pushed its jobs, so either the worker finds the new jobs or it gets woken up.
+					atomics::AtomicAddU32(&pool->sleepingWorkerCount, 1);
+					if (pool->GetNextJob(worker->queueIndex, job)) {
+						atomics::AtomicAddU32(&pool->sleepingWorkerCount, (u32)-1);
+						ExecuteJob(job);
+					} else {
+						if (!AtomicReadU32(&pool->isShutdown)) {
+							threading::SemaphoreWait(pool->wakeSemaphore);
+						}
+						atomics::AtomicAddU32(&pool->sleepingWorkerCount, (u32)-1);
+					}
+					idleCount = 0;
+				}
+			}
+			currentPool = nullptr;
+			currentQueueIndex = 0;
+		}
+
+		void WorkerPool::Init(const u32 workerCount) {
+			assert(threadCount == 0);
+			assert(queues == nullptr);
+			u32 count = workerCount;
+			if (count == 0) {
+				u32 coreCount = hardware::GetProcessorCoreCount();
+				count = coreCount > 1 ? coreCount - 1 : 0;
+			}
+			count = maths::Minimum(count, MAX_WORKER_THREAD_COUNT);
+
+			queueCount = count + 1;
+			queueMemory = mem::AllocateMemoryBlock(sizeof(JobQueue) * queueCount, 64);
+			queues = mem::PushArray<JobQueue>(&queueMemory, queueCount, true, 64);
+			sharedQueueLock.isLocked = 0;
+
+			wakeSemaphore = threading::SemaphoreCreate(0);
+			assert(wakeSemaphore.isValid);
+			sleepingWorkerCount = 0;
+			isShutdown = 0;
+			for (u32 threadIndex = 0; threadIndex < count; ++threadIndex) {
+				WorkerThread *worker = workerThreads + threadIndex;
+				worker->pool = this;
+				worker->queueIndex = threadIndex + 1;
+				// @NOTE: The platform layer sets the run function after the thread is created, so the thread must not run before that
+				threads[threadIndex] = threading::ThreadCreate(WorkerThreadProc, worker, false);
+				threading::ThreadResume(threads[threadIndex]);
+			}
+			threadCount = count;
+		}
+
+		void WorkerPool::Shutdown() {
+			if (threadCount > 0) {
+				atomics::AtomicExchangeU32(&isShutdown, 1);
+				// Wake up every worker, sleeping or not, a worker which is about to sleep sees the shutdown flag or gets one of these
+				threading::SemaphoreRelease(wakeSemaphore, threadCount);
+				threading::ThreadWaitForMultiple(threads, threadCount);
+				threadCount = 0;
+			}
+			if (wakeSemaphore.isValid) {
+				threading::SemaphoreDestroy(wakeSemaphore);
+			}
+			if (queues != nullptr) {
+				mem::ReleaseMemoryBlock(&queueMemory);
+				queues = nullptr;
+				queueCount = 0;
+			}
+		}
+
+		void WorkerPool::RunJobs(const Job *jobs, const u32 jobCount, JobCounter *counter) {
+			assert(queues != nullptr);
+			if (counter != nullptr) {
+				atomics::AtomicAddU32(&counter->pendingCount, jobCount);
+			}
+			u32 queueIndex = (currentPool == this) ? currentQueueIndex : 0;
+			for (u32 jobIndex = 0; jobIndex < jobCount; ++jobIndex) {
+				Job job = jobs[jobIndex];
+				job.counter = counter;
+				bool pushed;
+				if (queueIndex == 0) {
+					sharedQueueLock.Lock();
+					pushed = PushJob(0, job);
+					sharedQueueLock.Unlock();
+				} else {
+					pushed = PushJob(queueIndex, job);
+				}
+				if (!pushed) {
+					// Queue is full, so we just do the work ourself
+					ExecuteJob(job);
+				}
+			}
+
+			// Spinning workers finds the jobs by themself, only sleeping workers needs to be woken up
+			u32 sleepingCount = AtomicReadU32(&sleepingWorkerCount);
+			if (sleepingCount > 0) {
+				threading::SemaphoreRelease(wakeSemaphore, maths::Minimum(sleepingCount, jobCount));
+			}
+		}
+
+		void WorkerPool::WaitForCounter(JobCounter *counter) {
+			assert(counter != nullptr);
+			u32 queueIndex = (currentPool == this) ? currentQueueIndex : 0;
+			// @NOTE: Waiting threads execute jobs as well, so jobs can wait for other jobs without blocking a worker
+			while (AtomicReadU32(&counter->pendingCount) > 0) {
+				Job job;
+				if ((queues != nullptr) && GetNextJob(queueIndex, job)) {
+					ExecuteJob(job);
+				} else {
+					_mm_pause();
+				}
+			}
+		}
+
+		struct ParallelForContext {
+			parallel_for_function *function;
+			void *userData;
+			u32 itemCount;
+			u32 batchSize;
+			volatile u32 nextIndex;
+		};
+
+		static void ParallelForJob(void *userData) {
+			ParallelForContext *context = (ParallelForContext *)userData;
+			for (;;) {
+				u32 startIndex = atomics::AtomicAddU32(&context->nextIndex, context->batchSize);
+				if (startIndex >= context->itemCount) {
+					break;
+				}
+				u32 endIndex = maths::Minimum(startIndex + context->batchSize, context->itemCount);
+				context->function(startIndex, endIndex, context->userData);
+			}
+		}
+
+		void WorkerPool::ParallelFor(const u32 itemCount, const u32 batchSize, parallel_for_function *function, void *userData) {
+			assert(function != nullptr);
+			assert(batchSize > 0);
+			if (itemCount == 0) {
+				return;
+			}
+
+			// Not worth to wake up any workers
+			if (threadCount == 0 || itemCount <= batchSize) {
+				function(0, itemCount, userData);
+				return;
+			}
+
+			ParallelForContext context = {};
+			context.function = function;
+			context.userData = userData;
+			context.itemCount = itemCount;
+			context.batchSize = batchSize;
+			context.nextIndex = 0;
+
+			// @NOTE: One job per thread is enough, because every job grabs batches until all items are done
+			u32 batchCount = (itemCount + batchSize - 1) / batchSize;
+			u32 jobCount = maths::Minimum(batchCount, GetThreadCount());
+			Job jobs[MAX_WORKER_THREAD_COUNT + 1];
+			for (u32 jobIndex = 0; jobIndex < jobCount; ++jobIndex) {
+				jobs[jobIndex] = { ParallelForJob, &context, nullptr };
+			}
+
+			JobCounter counter = {};
+			RunJobs(jobs, jobCount, &counter);
+			WaitForCounter(&counter);
+		}
+
+		constexpr u32 TRIPLE_BUFFER_INDEX_MASK = 3;
+		constexpr u32 TRIPLE_BUFFER_NEW_BIT = 4;
+
+		TripleBuffer::TripleBuffer() :
+			memory({}),
+			buffers(),
+			bufferSize(0),
+			sharedState(0),
+			writeIndex(0),
+			readIndex(0),
+			hasRead(false) {
+		}
+
+		TripleBuffer::~TripleBuffer() {
+			Release();
+		}
+
+		void TripleBuffer::Init(const size_t bufferSize) {
+			assert(memory.base == nullptr);
+			assert(bufferSize > 0);
+			size_t alignedSize = (bufferSize + CACHE_LINE_SIZE - 1) & ~((size_t)CACHE_LINE_SIZE - 1);
+			memory = mem::AllocateMemoryBlock(alignedSize * 3, CACHE_LINE_SIZE);
+			for (u32 bufferIndex = 0; bufferIndex < 3; ++bufferIndex) {
+				buffers[bufferIndex] = mem::PushArray<u8>(&memory, alignedSize, true, CACHE_LINE_SIZE);
+			}
+			this->bufferSize = bufferSize;
+			writeIndex = 0;
+			sharedState = 1;
+			readIndex = 2;
+			hasRead = false;
+			atomics::AtomicWriteFence();
+		}
+
+		void TripleBuffer::Release() {
+			if (memory.base != nullptr) {
+				mem::ReleaseMemoryBlock(&memory);
+				buffers[0] = buffers[1] = buffers[2] = nullptr;
+				bufferSize = 0;
+				hasRead = false;
+			}
+		}
+
+		void *TripleBuffer::GetWriteBuffer() {
+			assert(memory.base != nullptr);
+			void *result = buffers[writeIndex];
+			return(result);
+		}
+
+		void TripleBuffer::Publish() {
+			assert(memory.base != nullptr);
+			// @NOTE: The exchange is a full barrier, so the buffer content is visible before the reader can get it
+			u32 oldState = atomics::AtomicExchangeU32(&sharedState, writeIndex | TRIPLE_BUFFER_NEW_BIT);
+			writeIndex = oldState & TRIPLE_BUFFER_INDEX_MASK;
+		}
+
+		const void *TripleBuffer::Read() {
+			assert(memory.base != nullptr);
+			if (AtomicReadU32(&sharedState) & TRIPLE_BUFFER_NEW_BIT) {
+				u32 oldState = atomics::AtomicExchangeU32(&sharedState, readIndex);
+				readIndex = oldState & TRIPLE_BUFFER_INDEX_MASK;
+				hasRead = true;
+			}
+			const void *result = hasRead ? buffers[readIndex] : nullptr;
+			return(result);
+		}
+
+		// Baseline for the benchmark
+		template <typename T>
+		class MutexQueue {
+		private:
+			std::deque<T> queue;
+			std::mutex queueMutex;
+		public:
+			inline bool Push(const T &value) {
+				std::unique_lock<std::mutex> lock(queueMutex);
+				queue.push_back(value);
+				return true;
+			}
+
+			inline bool Pop(T &out) {
+				std::unique_lock<std::mutex> lock(queueMutex);
+				if (queue.empty()) {
+					return false;
+				}
+				out = queue.front();
+				queue.pop_front();
+				return true;
+			}
+		};
+
+		struct QueueBenchmarkState {
+			volatile u32 readyCount;
+			volatile u32 isStarted;
+			volatile u32 poppedCount;
+			u32 itemCount;
+			u32 producerCount;
+			u32 threadCount;
+		};
+
+		template <typename TQueue>
+		static void QueueBenchmarkProducer(TQueue *queue, QueueBenchmarkState *state, const u32 producerIndex) {
+			atomics::AtomicAddU32(&state->readyCount, 1);
+			while (!AtomicReadU32(&state->isStarted)) {
+				_mm_pause();
+			}
+			u32 startIndex = (u32)(((u64)state->itemCount * producerIndex) / state->producerCount);
+			u32 endIndex = (u32)(((u64)state->itemCount * (producerIndex + 1)) / state->producerCount);
+			for (u32 itemIndex = startIndex; itemIndex < endIndex; ++itemIndex) {
+				u64 value = (u64)itemIndex + 1;
+				while (!queue->Push(value)) {
+					_mm_pause();
+				}
+			}
+		}
+
+		template <typename TQueue>
+		static void QueueBenchmarkConsumer(TQueue *queue, QueueBenchmarkState *state, u64 *outSum) {
+			atomics::AtomicAddU32(&state->readyCount, 1);
+			while (!AtomicReadU32(&state->isStarted)) {
+				_mm_pause();
+			}
+			u64 sum = 0;
+			while (AtomicReadU32(&state->poppedCount) < state->itemCount) {
+				u64 value;
+				if (queue->Pop(value)) {
+					sum += value;
+					atomics::AtomicAddU32(&state->poppedCount, 1);
+				} else {
+					_mm_pause();
+				}
+			}
+			*outSum = sum;
+		}
+
+		// Returns the number of seconds it takes to transfer all items or a negative value when items got lost
+		template <typename TQueue>
+		static f64 MeasureQueue(TQueue *queue, const u32 producerCount, const u32 consumerCount, const u32 itemCount) {
+			QueueBenchmarkState state = {};
+			state.itemCount = itemCount;
+			state.producerCount = producerCount;
+			state.threadCount = producerCount + consumerCount;
+
+			// @NOTE: The platform layer limits the number of threads created over the lifetime of the process, so the benchmark uses standard threads
+			std::vector<u64> sums(consumerCount, 0);
+			std::vector<std::thread> threads;
+			threads.reserve(state.threadCount);
+			for (u32 producerIndex = 0; producerIndex < producerCount; ++producerIndex) {
+				threads.emplace_back(QueueBenchmarkProducer<TQueue>, queue, &state, producerIndex);
+			}
+			for (u32 consumerIndex = 0; consumerIndex < consumerCount; ++consumerIndex) {
+				threads.emplace_back(QueueBenchmarkConsumer<TQueue>, queue, &state, &sums[consumerIndex]);
+			}
+			while (AtomicReadU32(&state.readyCount) < state.threadCount) {
+				_mm_pause();
+			}
+
+			f64 startTime = timings::GetHighResolutionTimeInSeconds();
+			atomics::AtomicExchangeU32(&state.isStarted, 1);
+			for (std::thread &thread : threads) {
+				thread.join();
+			}
+			f64 result = timings::GetHighResolutionTimeInSeconds() - startTime;
+
+			u64 totalSum = 0;
+			for (u32 consumerIndex = 0; consumerIndex < consumerCount; ++consumerIndex) {
+				totalSum += sums[consumerIndex];
+			}
+			u64 expectedSum = ((u64)itemCount * ((u64)itemCount + 1)) / 2;
+			if (totalSum != expectedSum) {
+				result = -1.0;
+			}
+			return(result);
+		}
+
+		void RunConcurrentQueueBenchmark(const u32 maxThreadCount, const u32 itemCount) {
+			assert(maxThreadCount > 0);
+			assert(itemCount > 0);
+			if (!InitPlatform(InitFlags::None)) {
+				return;
+			}
+
+			constexpr u32 QueueCapacity = 4096;
+			console::ConsoleFormatOut("Concurrent queue benchmark, %u items, capacity %u\n", itemCount, QueueCapacity);
+			console::ConsoleFormatOut("Producers Consumers Lock-free [items/s] Mutex [items/s]\n");
+			for (u32 producerCount = 1; producerCount <= maxThreadCount; ++producerCount) {
+				for (u32 consumerCount = 1; consumerCount <= maxThreadCount; ++consumerCount) {
+					ConcurrentQueue<u64> lockFreeQueue;
+					lockFreeQueue.Init(QueueCapacity);
+					f64 lockFreeTime = MeasureQueue(&lockFreeQueue, producerCount, consumerCount, itemCount);
+					lockFreeQueue.Release();
+
+					MutexQueue<u64> mutexQueue;
+					f64 mutexTime = MeasureQueue(&mutexQueue, producerCount, consumerCount, itemCount);
+
+					if (lockFreeTime <= 0.0 || mutexTime <= 0.0) {
+						console::ConsoleFormatOut("%9u %9u Failed, items got lost!\n", producerCount, consumerCount);
+						continue;
+					}
+					console::ConsoleFormatOut("%9u %9u %19.0f %16.0f\n", producerCount, consumerCount, (f64)itemCount / lockFreeTime, (f64)itemCount / mutexTime);
+				}
+			}
+			ReleasePlatform();
+		}
+	}
+}
\ No newline at end of file
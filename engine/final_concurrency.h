@@ -1,32 +1,280 @@
 #pragma once
 
+#include <type_traits>
+#include <xmmintrin.h>
+
+#include <final_platform_layer.hpp>
+
+#include "final_types.h"
+#include "final_mem.h"
+
 namespace fs {
 	namespace concurrency {
+		// Executes the items from startIndex up to (but not including) endIndex
+		typedef void (parallel_for_function)(const u32 startIndex, const u32 endIndex, void *userData);
+		// Executes a single job
+		typedef void (job_function)(void *userData);
+
+		constexpr u32 MAX_WORKER_THREAD_COUNT = 32;
+		constexpr u32 CACHE_LINE_SIZE = 64;
+		// Number of jobs a single queue can hold, must be a power of two
+		constexpr u32 JOB_QUEUE_CAPACITY = 1024;
+
+		// @NOTE: Implemented as a locked add, because the platform fences are compiler barriers only
+		inline u32 AtomicReadU32(volatile u32 *value) {
+			u32 result = fpl::atomics::AtomicAddU32(value, 0);
+			return(result);
+		}
+
+		// Simple lock for very short critical sections, the waiting thread just spins
+		struct SpinLock {
+			volatile u32 isLocked;
+
+			inline void Lock() {
+				while (fpl::atomics::AtomicCompareExchangeU32(&isLocked, 1, 0) != 0) {
+					_mm_pause();
+				}
+			}
+			inline void Unlock() {
+				fpl::atomics::AtomicExchangeU32(&isLocked, 0);
+			}
+		};
+
+		// Number of jobs which are not finished yet, used to wait for a group of jobs
+		struct JobCounter {
+			volatile u32 pendingCount;
+		};
+
+		struct Job {
+			job_function *function;
+			void *userData;
+			// Decremented when the job is done, may be null
+			JobCounter *counter;
+		};
+
+		// Chase-Lev work stealing deque with a fixed capacity.
+		// The owner pushes and pops jobs at the bottom, all other threads steal jobs from the top.
+		struct JobQueue {
+			Job jobs[JOB_QUEUE_CAPACITY];
+			volatile u32 top;
+			// @NOTE: Top and bottom are written by different threads, so these are kept on separate cache lines
+			u8 padding[CACHE_LINE_SIZE - sizeof(u32)];
+			volatile u32 bottom;
+			u8 padding2[CACHE_LINE_SIZE - sizeof(u32)];
+		};
+
+		// Job system with persistent worker threads, each worker has its own job queue and steals jobs from the other queues when it has nothing to do.
+		// @NOTE: The platform layer has a lifetime limit of threads, so threads are created once and reused for every job.
+		class WorkerPool {
+		private:
+			struct WorkerThread {
+				WorkerPool *pool;
+				u32 queueIndex;
+			};
+
+			fpl::threading::ThreadContext threads[MAX_WORKER_THREAD_COUNT];
+			WorkerThread workerThreads[MAX_WORKER_THREAD_COUNT];
+			u32 threadCount;
+			volatile u32 isShutdown;
+
+			// One queue per worker thread plus a shared queue at index zero, which is used by all other threads
+			mem::MemoryBlock queueMemory;
+			JobQueue *queues;
+			u32 queueCount;
+			// The shared queue has no single owner, so pushing and popping is guarded by this lock
+			SpinLock sharedQueueLock;
+			// Idle workers sleeps on this semaphore until RunJobs() or Shutdown() wakes them up
+			fpl::threading::SemaphoreHandle wakeSemaphore;
+			volatile u32 sleepingWorkerCount;
+
+			bool PushJob(const u32 queueIndex, const Job &job);
+			bool PopJob(const u32 queueIndex, Job &outJob);
+			bool StealJob(const u32 queueIndex, Job &outJob);
+			// Pops a job from the own queue or steals one from any other queue
+			bool GetNextJob(const u32 queueIndex, Job &outJob);
+			static void ExecuteJob(const Job &job);
+			static void WorkerThreadProc(const fpl::threading::ThreadContext &context, void *data);
+		public:
+			// Creates the worker threads, when workerCount is zero it uses the processor count minus one (the waiting thread works as well)
+			void Init(const u32 workerCount = 0);
+			void Shutdown();
+			// Adds the jobs to the queue of the calling thread, the counter is increased by the number of jobs
+			void RunJobs(const Job *jobs, const u32 jobCount, JobCounter *counter);
+			// Executes jobs until the counter is zero
+			void WaitForCounter(JobCounter *counter);
+			// Splits the items into batches and executes them on all workers and the calling thread, returns when all items are done
+			void ParallelFor(const u32 itemCount, const u32 batchSize, parallel_for_function *function, void *userData);
+
+			inline u32 GetThreadCount() const {
+				return threadCount + 1;
+			}
+
+			WorkerPool();
+			~WorkerPool();
+		};
+
+		// Bounded multi producer / multi consumer queue without locks (Dmitry Vyukov's sequence numbered ring buffer).
+		// Each cell has a sequence number which tells whether the cell is ready for the next push or the next pop, so producers and consumers only race on their own position.
+		// @NOTE: The memory is allocated once in Init, pushing and popping never allocates. Values are copied with memcpy semantics, so only trivially copyable types are allowed.
 		template <typename T>
 		class ConcurrentQueue {
+			static_assert(std::is_trivially_copyable<T>::value, "Concurrent queue values must be trivially copyable");
 		private:
-			//std::deque<T> _queue;
-			//std::mutex _queueMutex;
+			struct Cell {
+				volatile u32 sequence;
+				T value;
+			};
+
+			u8 padding0[CACHE_LINE_SIZE];
+			mem::MemoryBlock memory;
+			Cell *cells;
+			u32 mask;
+			u8 padding1[CACHE_LINE_SIZE];
+			volatile u32 pushPosition;
+			u8 padding2[CACHE_LINE_SIZE - sizeof(u32)];
+			volatile u32 popPosition;
+			u8 padding3[CACHE_LINE_SIZE - sizeof(u32)];
 		public:
-			inline void Push(T value) {
-				//std::unique_lock<std::mutex> lock(_queueMutex);
-				//_queue.push_back(value);
-			}
-
-			inline bool Pop(T &out) {
-			#if 0
-				std::unique_lock<std::mutex> lock(_queueMutex, std::defer_lock);
-				lock.lock();
-				if (!_queue.empty()) {
-					T value = _queue.front();
-					_queue.pop_front();
-					out = value;
+			ConcurrentQueue() :
+				memory({}),
+				cells(nullptr),
+				mask(0),
+				pushPosition(0),
+				popPosition(0) {
+			}
+			~ConcurrentQueue() {
+				Release();
+			}
+			ConcurrentQueue(const ConcurrentQueue &) = delete;
+			ConcurrentQueue &operator =(const ConcurrentQueue &) = delete;
+
+			// Allocates the cells, the capacity is rounded up to the next power of two
+			void Init(const u32 capacity) {
+				assert(cells == nullptr);
+				assert(capacity > 0 && capacity <= (1u << 30));
+				u32 cellCount = 2;
+				while (cellCount < capacity) {
+					cellCount <<= 1;
+				}
+				memory = mem::AllocateMemoryBlock(sizeof(Cell) * cellCount, CACHE_LINE_SIZE);
+				cells = mem::PushArray<Cell>(&memory, cellCount, true, CACHE_LINE_SIZE);
+				for (u32 cellIndex = 0; cellIndex < cellCount; ++cellIndex) {
+					cells[cellIndex].sequence = cellIndex;
+				}
+				mask = cellCount - 1;
+				pushPosition = 0;
+				popPosition = 0;
+				fpl::atomics::AtomicWriteFence();
+			}
+
+			void Release() {
+				if (cells != nullptr) {
+					mem::ReleaseMemoryBlock(&memory);
+					cells = nullptr;
+					mask = 0;
+				}
+			}
+
+			// Returns false when the queue is full
+			bool Push(const T &value) {
+				assert(cells != nullptr);
+				Cell *cell;
+				u32 position = AtomicReadU32(&pushPosition);
+				for (;;) {
+					cell = cells + (position & mask);
+					u32 sequence = AtomicReadU32(&cell->sequence);
+					s32 difference = (s32)(sequence - position);
+					if (difference == 0) {
+						// Cell is free, try to claim it
+						u32 oldPosition = fpl::atomics::AtomicCompareExchangeU32(&pushPosition, position + 1, position);
+						if (oldPosition == position) {
+							break;
+						}
+						position = oldPosition;
+					} else if (difference < 0) {
+						// Cell is not popped yet, so the queue is full
+						return false;
+					} else {
+						// Another producer was faster
+						position = AtomicReadU32(&pushPosition);
+					}
 				}
-				lock.unlock();
-			#endif
-				return false;
+				cell->value = value;
+				// @NOTE: The exchange publishes the value, consumers will not read the cell before the sequence is changed
+				fpl::atomics::AtomicExchangeU32(&cell->sequence, position + 1);
+				return true;
+			}
+
+			// Returns false when the queue is empty
+			bool Pop(T &out) {
+				assert(cells != nullptr);
+				Cell *cell;
+				u32 position = AtomicReadU32(&popPosition);
+				for (;;) {
+					cell = cells + (position & mask);
+					u32 sequence = AtomicReadU32(&cell->sequence);
+					s32 difference = (s32)(sequence - (position + 1));
+					if (difference == 0) {
+						// Cell is filled, try to claim it
+						u32 oldPosition = fpl::atomics::AtomicCompareExchangeU32(&popPosition, position + 1, position);
+						if (oldPosition == position) {
+							break;
+						}
+						position = oldPosition;
+					} else if (difference < 0) {
+						// Cell is not pushed yet, so the queue is empty
+						return false;
+					} else {
+						// Another consumer was faster
+						position = AtomicReadU32(&popPosition);
+					}
+				}
+				out = cell->value;
+				// Cell is free again for the push one round later
+				fpl::atomics::AtomicExchangeU32(&cell->sequence, position + mask + 1);
+				return true;
+			}
+
+			inline u32 GetCapacity() const {
+				return cells != nullptr ? mask + 1 : 0;
+			}
+		};
+
+		// Three equally sized buffers for passing data from a single writer thread to a single reader thread without waiting.
+		// The writer fills the write buffer and publishes it, the reader always gets the latest published buffer.
+		// @NOTE: Buffers which are published but never read are simply overwritten, so the reader may skip data.
+		class TripleBuffer {
+		private:
+			mem::MemoryBlock memory;
+			u8 *buffers[3];
+			size_t bufferSize;
+			// Index of the buffer which is neither written nor read, with TRIPLE_BUFFER_NEW_BIT set when it was published but not read yet
+			volatile u32 sharedState;
+			u32 writeIndex;
+			u32 readIndex;
+			bool hasRead;
+		public:
+			TripleBuffer();
+			~TripleBuffer();
+			TripleBuffer(const TripleBuffer &) = delete;
+			TripleBuffer &operator =(const TripleBuffer &) = delete;
+
+			void Init(const size_t bufferSize);
+			void Release();
+			// Writer only: Buffer which is written next, its content is undefined
+			void *GetWriteBuffer();
+			// Writer only: Makes the write buffer available to the reader
+			void Publish();
+			// Reader only: Latest published buffer or null when nothing was published yet
+			const void *Read();
+
+			inline size_t GetBufferSize() const {
+				return bufferSize;
 			}
 		};
 
+		// Measures the throughput of the concurrent queue against a mutex and deque based queue, for every combination of 1 to maxThreadCount producers and consumers.
+		// Prints the number of transferred items per second to the console. Initializes the platform by itself, so it cannot run next to a game.
+		extern void RunConcurrentQueueBenchmark(const u32 maxThreadCount, const u32 itemCount);
 	};
 };
\ No newline at end of file
@@ -8,9 +8,72 @@
 #include "final_utils.h"
 #include "final_renderer.h"
 #include "final_openglrenderer.h"
+#include "final_rendercommands.h"
+#include "final_softwarerenderer.h"
 
 namespace fs {
 	namespace games {
+		// Size of the memory block which is cleared every frame
+		constexpr size_t FRAME_MEMORY_SIZE = 16 * 1024 * 1024;
+		// Size of the header in front of each game snapshot, keeps the game snapshot 16 byte aligned
+		constexpr size_t SNAPSHOT_HEADER_SIZE = 16;
+
+		struct SnapshotHeader {
+			// Time when the simulation reached the state of the snapshot
+			f64 time;
+		};
+
+		struct SimulationThread {
+			BaseGame *game;
+			// Snapshots from the simulation thread to the render thread
+			TripleBuffer snapshots;
+			// Guards the game against updating and handling input at the same time
+			SpinLock gameLock;
+			// Latest input from the render thread, guarded by the game lock
+			Input input;
+			f64 deltaTime;
+			volatile u32 isShutdown;
+			// Number of updates since the last read by the render thread
+			volatile u32 updateCount;
+		};
+
+		static void SimulationThreadProc(const threading::ThreadContext &context, void *data) {
+			SimulationThread *simulation = (SimulationThread *)data;
+			BaseGame *game = simulation->game;
+			const f64 deltaTime = simulation->deltaTime;
+			f64 lastTime = timings::GetHighResolutionTimeInSeconds();
+			f64 frameAccumulator = deltaTime;
+			while (!AtomicReadU32(&simulation->isShutdown)) {
+				f64 currentTime = timings::GetHighResolutionTimeInSeconds();
+				frameAccumulator = Clamp(frameAccumulator + (currentTime - lastTime), 0.0, 0.5);
+				lastTime = currentTime;
+				if (frameAccumulator < deltaTime) {
+					// @NOTE: The sleep granularity may be very coarse, so we only sleep when the next step is not too close
+					if ((deltaTime - frameAccumulator) > 0.002) {
+						threading::ThreadSleep(1);
+					} else {
+						_mm_pause();
+					}
+					continue;
+				}
+				while (frameAccumulator >= deltaTime) {
+					frameAccumulator -= deltaTime;
+
+					simulation->gameLock.Lock();
+					Input input = simulation->input;
+					game->Update(input);
+					u8 *snapshot = (u8 *)simulation->snapshots.GetWriteBuffer();
+					SnapshotHeader *header = (SnapshotHeader *)snapshot;
+					header->time = currentTime - frameAccumulator;
+					game->WriteSnapshot(snapshot + SNAPSHOT_HEADER_SIZE);
+					simulation->snapshots.Publish();
+					simulation->gameLock.Unlock();
+
+					atomics::AtomicAddU32(&simulation->updateCount, 1);
+				}
+			}
+		}
+
 		static void UpdateKeyboardButtonState(const b32 isDown, ButtonState &targetButton) {
 			if (isDown != targetButton.isDown) {
 				targetButton.isDown = isDown;
@@ -316,7 +379,7 @@ namespace fs {
 			}
 		}
 
-		extern void RunGame(BaseGame *game) {
+		extern void RunGame(BaseGame *game, const bool useSimulationThread) {
 			InitSettings platformSettings = InitSettings();
 			platformSettings.window.windowWidth = game->GetInitialWidth();
 			platformSettings.window.windowHeight = game->GetInitialHeight();
@@ -326,16 +389,29 @@ namespace fs {
 			}
 			platformSettings.video.isVSync = false;
 			if (InitPlatform(InitFlags::VideoOpenGL, platformSettings)) {
-				Renderer *renderer = (Renderer *)new OpenGLRenderer();
+				Renderer *backendRenderer = (Renderer *)new OpenGLRenderer();
+				backendRenderer->isBatchingEnabled = true;
+
+				// @NOTE: The game only records render commands, which are replayed on the backend after the game has rendered
+				CommandBufferRenderer *commandRenderer = new CommandBufferRenderer(backendRenderer);
+				Renderer *renderer = (Renderer *)commandRenderer;
 
 			#if FS_ENABLE_IMGUI
 				InitImGUI();
 			#endif
 
+				WorkerPool *workerPool = new WorkerPool();
+				workerPool->Init();
+
+				mem::MemoryBlock frameMemory = mem::AllocateMemoryBlock(FRAME_MEMORY_SIZE, 16, mem::MemoryBlockFlags::GuardPage);
+
 				game->SetRenderer(renderer);
+				game->SetWorkerPool(workerPool);
+				game->SetFrameMemory(&frameMemory);
 				game->Init();
 
-				constexpr f32 TargetDeltaTime = 1.0f / 60.0f;
+				assert(game->GetUpdateRate() > 0);
+				const f32 TargetDeltaTime = 1.0f / (f32)game->GetUpdateRate();
 
 				f64 lastTime = timings::GetHighResolutionTimeInSeconds();
 				f64 fpsTimerInSecs = timings::GetHighResolutionTimeInSeconds();
@@ -348,9 +424,24 @@ namespace fs {
 				Input *prevInput = &inputs[1];
 				Vec2i lastMousePos = Vec2i(-1, -1);
 
+				// Games without snapshots are always updated on the render thread
+				SimulationThread *simulation = nullptr;
+				const threading::ThreadContext *simulationThreadContext = nullptr;
+				if (useSimulationThread && game->GetSnapshotSize() > 0) {
+					simulation = new SimulationThread();
+					simulation->game = game;
+					simulation->deltaTime = TargetDeltaTime;
+					simulation->snapshots.Init(SNAPSHOT_HEADER_SIZE + game->GetSnapshotSize());
+					// @NOTE: The platform layer sets the run function after the thread is created, so the thread must not run before that
+					simulationThreadContext = &threading::ThreadCreate(SimulationThreadProc, simulation, false);
+					threading::ThreadResume(*simulationThreadContext);
+				}
+
 				// Loop
 				bool isWindowActive = true;
 				while (!game->IsExitRequested() && WindowUpdate()) {
+					mem::ClearMemoryBlock(&frameMemory);
+
 					//
 					// Window size
 					//
@@ -422,7 +513,19 @@ namespace fs {
 					//
 					// Tick & Update
 					//
-					{
+					if (simulation != nullptr) {
+						// @NOTE: Input handling may change the game, so the simulation thread has to wait
+						simulation->gameLock.Lock();
+						game->HandleInput(*currentInput);
+						simulation->input = *currentInput;
+						size_t snapshotSize = SNAPSHOT_HEADER_SIZE + game->GetSnapshotSize();
+						if (snapshotSize > simulation->snapshots.GetBufferSize()) {
+							// Snapshots got larger (entities were added), the old snapshots are dropped
+							simulation->snapshots.Release();
+							simulation->snapshots.Init(snapshotSize);
+						}
+						simulation->gameLock.Unlock();
+					} else {
 						game->HandleInput(*currentInput);
 						frameAccumulator = Clamp(frameAccumulator, 0.0, 0.5);
 						while (frameAccumulator >= TargetDeltaTime) {
@@ -436,7 +539,20 @@ namespace fs {
 					// Render
 					//
 					{
-						game->Render(*currentInput);
+						if (simulation != nullptr) {
+							// Render the latest snapshot, interpolated by the time passed since the simulation has reached it
+							const u8 *snapshot = (const u8 *)simulation->snapshots.Read();
+							if (snapshot != nullptr) {
+								const SnapshotHeader *header = (const SnapshotHeader *)snapshot;
+								f64 alpha = (timings::GetHighResolutionTimeInSeconds() - header->time) / TargetDeltaTime;
+								game->RenderSnapshot(*currentInput, snapshot + SNAPSHOT_HEADER_SIZE, (f32)Clamp(alpha, 0.0, 1.0));
+							}
+						} else {
+							// The time left in the accumulator is the part of the next step which is not simulated yet
+							f64 alpha = frameAccumulator / TargetDeltaTime;
+							game->Render(*currentInput, (f32)Clamp(alpha, 0.0, 1.0));
+						}
+						commandRenderer->Submit();
 
 					#if FS_ENABLE_IMGUI
 						// Render UI
@@ -456,6 +572,9 @@ namespace fs {
 						f64 frameDuration = frameEndTime - lastTime;
 						frameAccumulator += frameDuration;
 						lastTime = frameEndTime;
+						if (simulation != nullptr) {
+							updateCount += atomics::AtomicExchangeU32(&simulation->updateCount, 0);
+						}
 						if (frameEndTime >= (fpsTimerInSecs + 1.0)) {
 							fpsTimerInSecs = frameEndTime;
 							ConsoleFormatOut("Fps: %d, Ups: %d\n", frameCount, updateCount);
@@ -469,11 +588,140 @@ namespace fs {
 				}
 
 				// Release resources
+				if (simulation != nullptr) {
+					atomics::AtomicExchangeU32(&simulation->isShutdown, 1);
+					threading::ThreadWaitForSingle(*simulationThreadContext);
+					delete simulation;
+				}
 				game->Release();
 			#if FS_ENABLE_IMGUI
 				ReleaseImGUI();
 			#endif
-				delete renderer;
+				mem::ReleaseMemoryBlock(&frameMemory);
+				workerPool->Shutdown();
+				delete workerPool;
+				delete commandRenderer;
+				delete backendRenderer;
+				ReleasePlatform();
+			}
+		}
+
+		// FNV-1a hash of the framebuffer pixels
+		static u64 HashFramebuffer(const SoftwareFramebuffer &framebuffer) {
+			u64 result = 14695981039346656037ULL;
+			const u8 *bytes = (const u8 *)framebuffer.pixels;
+			for (u32 byteIndex = 0; byteIndex < framebuffer.width * framebuffer.height * 4; ++byteIndex) {
+				result = (result ^ bytes[byteIndex]) * 1099511628211ULL;
+			}
+			return(result);
+		}
+
+		extern void RunGameHeadless(BaseGame *game, const u32 width, const u32 height, const u32 frameCount, const char *recordFilePath) {
+			// @NOTE: No window and no video context, everything is rendered on the CPU
+			if (InitPlatform(InitFlags::None)) {
+				SoftwareRenderer *softwareRenderer = new SoftwareRenderer(width, height);
+
+				// For recording the game draws into a command buffer, which is replayed on the software renderer
+				CommandBufferRenderer *commandRenderer = nullptr;
+				Renderer *renderer = softwareRenderer;
+				if (recordFilePath != nullptr) {
+					commandRenderer = new CommandBufferRenderer(softwareRenderer);
+					commandRenderer->windowSize = Vec2i(width, height);
+					renderer = commandRenderer;
+				}
+
+				WorkerPool *workerPool = new WorkerPool();
+				workerPool->Init();
+				softwareRenderer->SetWorkerPool(workerPool);
+
+				mem::MemoryBlock frameMemory = mem::AllocateMemoryBlock(FRAME_MEMORY_SIZE, 16, mem::MemoryBlockFlags::GuardPage);
+
+				game->SetRenderer(renderer);
+				game->SetWorkerPool(workerPool);
+				game->SetFrameMemory(&frameMemory);
+				game->Init();
+
+				assert(game->GetUpdateRate() > 0);
+				const f32 TargetDeltaTime = 1.0f / (f32)game->GetUpdateRate();
+
+				// Fixed timestep and empty input, so each run produces the exact same frames
+				Input input = {};
+				input.deltaTime = TargetDeltaTime;
+				input.keyboard.isConnected = true;
+				input.mouse.pos = Vec2i(-1, -1);
+
+				f64 totalRenderTime = 0.0;
+				for (u32 frameIndex = 0; frameIndex < frameCount && !game->IsExitRequested(); ++frameIndex) {
+					mem::ClearMemoryBlock(&frameMemory);
+
+					game->HandleInput(input);
+					game->Update(input);
+
+					f64 renderStartTime = timings::GetHighResolutionTimeInSeconds();
+					// @NOTE: Exactly one update per frame, so the current step is always drawn
+					game->Render(input, 1.0f);
+					if (commandRenderer != nullptr) {
+						commandRenderer->Submit();
+					}
+					totalRenderTime += timings::GetHighResolutionTimeInSeconds() - renderStartTime;
+				}
+
+				u64 frameHash = HashFramebuffer(softwareRenderer->GetFramebuffer());
+				f64 averageRenderTime = frameCount > 0 ? (totalRenderTime / (f64)frameCount) : 0.0;
+				ConsoleFormatOut("Frames: %u, Avg render time: %f ms, Frame hash: %llx\n", frameCount, averageRenderTime * 1000.0, frameHash);
+
+				if (commandRenderer != nullptr) {
+					// Submit() keeps the commands of the last frame around, so we just write them out
+					if (commandRenderer->SaveToFile(recordFilePath)) {
+						ConsoleFormatOut("Recorded %u commands (%u bytes) to '%s'\n", commandRenderer->GetSubmittedCommandCount(), commandRenderer->GetSubmittedCommandSize(), recordFilePath);
+					} else {
+						ConsoleFormatError("Failed to write the recorded frame to '%s'!\n", recordFilePath);
+					}
+				}
+
+				game->Release();
+				mem::ReleaseMemoryBlock(&frameMemory);
+				workerPool->Shutdown();
+				delete workerPool;
+				delete commandRenderer;
+				delete softwareRenderer;
+				ReleasePlatform();
+			}
+		}
+
+		extern void ReplayRecordedFrame(const char *filePath, const u32 replayCount) {
+			if (InitPlatform(InitFlags::None)) {
+				RenderCommandBuffer buffer = {};
+				std::vector<RecordedTexture> textures;
+				if (LoadRenderCommands(filePath, &buffer, textures)) {
+					// @NOTE: The recorded update command sets the window size, so the initial size does not matter
+					SoftwareRenderer *renderer = new SoftwareRenderer(1, 1);
+					WorkerPool *workerPool = new WorkerPool();
+					workerPool->Init();
+					renderer->SetWorkerPool(workerPool);
+					UploadRecordedTextures(renderer, textures.data(), (u32)textures.size());
+
+					f64 totalReplayTime = 0.0;
+					for (u32 replayIndex = 0; replayIndex < replayCount; ++replayIndex) {
+						f64 replayStartTime = timings::GetHighResolutionTimeInSeconds();
+						if (!ReplayRenderCommands(buffer, renderer, textures.data(), (u32)textures.size())) {
+							ConsoleFormatError("Failed to replay the recorded frame '%s'!\n", filePath);
+							break;
+						}
+						totalReplayTime += timings::GetHighResolutionTimeInSeconds() - replayStartTime;
+					}
+
+					u64 frameHash = HashFramebuffer(renderer->GetFramebuffer());
+					f64 averageReplayTime = replayCount > 0 ? (totalReplayTime / (f64)replayCount) : 0.0;
+					ConsoleFormatOut("Replays: %u, Commands: %u, Avg replay time: %f ms, Frame hash: %llx\n", replayCount, buffer.commandCount, averageReplayTime * 1000.0, frameHash);
+
+					workerPool->Shutdown();
+					delete workerPool;
+					delete renderer;
+					ReleaseRenderCommands(&buffer);
+				} else {
+					ConsoleFormatError("Failed to load the recorded frame '%s'!\n", filePath);
+				}
 				ReleasePlatform();
 			}
 		}
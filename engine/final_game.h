@@ -8,9 +8,12 @@
 
 #include "final_renderer.h"
 #include "final_input.h"
+#include "final_concurrency.h"
+#include "final_mem.h"
 
 using namespace fs::renderer;
 using namespace fs::inputs;
+using namespace fs::concurrency;
 
 namespace fs {
 	namespace games {
@@ -18,22 +21,45 @@ namespace fs {
 		protected:
 			u32 initialWidth;
 			u32 initialHeight;
+			// Number of fixed update steps per second, rendering is interpolated between the steps
+			u32 updateRate;
 			char *title;
 			Renderer *renderer;
+			WorkerPool *workerPool;
+			// Cleared at the start of each frame, for anything which is not needed in the next frame.
+			// @NOTE: It is cleared on the render thread, so it must not be used in Update() when the simulation thread is used.
+			mem::MemoryBlock *frameMemory;
 			bool exitRequested;
 		public:
 			BaseGame() :
 				renderer(nullptr),
+				workerPool(nullptr),
+				frameMemory(nullptr),
 				exitRequested(false),
 				initialWidth(1280),
 				initialHeight(720),
+				updateRate(60),
 				title(nullptr) {
 			}
 			virtual void Init() = 0;
 			virtual void Release() = 0;
 			virtual void HandleInput(const Input &input) = 0;
 			virtual void Update(const Input &input) = 0;
-			virtual void Render(const Input &input) = 0;
+			// Alpha is the position between the previous and the current update step in the range of 0 to 1, the previous step is drawn at zero
+			virtual void Render(const Input &input, const f32 alpha) = 0;
+
+			// Optional simulation thread (see RunGame): Update() runs on its own thread and the render thread draws published snapshots only.
+			// A game supports it by returning a snapshot size greater than zero, the size may grow in HandleInput() only.
+			virtual size_t GetSnapshotSize() const {
+				return 0;
+			}
+			// Called on the simulation thread after each update, must copy everything which changes in Update() and is needed for rendering
+			virtual void WriteSnapshot(void *snapshot) {
+			}
+			// Called on the render thread while Update() may run, so it must only read the snapshot and data which is changed in HandleInput().
+			// Alpha is the position between the previous and the current update step of the snapshot, in the range of 0 to 1.
+			virtual void RenderSnapshot(const Input &input, const void *snapshot, const f32 alpha) {
+			}
 			virtual ~BaseGame() {
 			}
 			inline bool IsExitRequested() const {
@@ -45,14 +71,29 @@ namespace fs {
 			inline u32 GetInitialHeight() const {
 				return initialHeight;
 			}
+			inline u32 GetUpdateRate() const {
+				return updateRate;
+			}
 			inline const char *GetTitle() const {
 				return title;
 			}
 			inline void SetRenderer(Renderer *renderer) {
 				this->renderer = renderer;
 			}
+			inline void SetWorkerPool(WorkerPool *workerPool) {
+				this->workerPool = workerPool;
+			}
+			inline void SetFrameMemory(mem::MemoryBlock *frameMemory) {
+				this->frameMemory = frameMemory;
+			}
 		};
 
-		extern void RunGame(BaseGame *game);
+		// Runs the game in a window, with useSimulationThread the fixed step updates run on a separate thread when the game supports snapshots
+		extern void RunGame(BaseGame *game, const bool useSimulationThread = false);
+		// Runs the game without a window and renders into a software framebuffer, prints the frame timings and a hash of the last frame.
+		// With a record file path the commands of the last frame are saved to that file, so they can be replayed by ReplayRecordedFrame().
+		extern void RunGameHeadless(BaseGame *game, const u32 width, const u32 height, const u32 frameCount, const char *recordFilePath = nullptr);
+		// Replays a recorded frame into a software framebuffer without any game, prints the timings and a hash of the frame
+		extern void ReplayRecordedFrame(const char *filePath, const u32 replayCount);
 	};
 };
\ No newline at end of file
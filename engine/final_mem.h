@@ -4,53 +4,138 @@
 
 namespace fs {
 	namespace mem {
+		enum class MemoryBlockFlags : uint32_t {
+			None = 0,
+			// @NOTE: Places a no-access page directly behind the block, so any overflow crashes right away. Only used in debug builds on windows.
+			GuardPage = 1 << 0,
+		};
+
 		struct MemoryBlock {
 			size_t size;
 			size_t offset;
 			void *base;
+			// Number of temporary memory scopes which are not ended yet
+			uint32_t temporaryCount;
+			// Start of the guarded allocation or null
+			void *guardAllocation;
+		};
+
+		// Saved offset of a memory block, everything pushed after the begin is popped by the end
+		struct TemporaryMemory {
+			MemoryBlock *block;
+			size_t offset;
 		};
 
-		inline MemoryBlock AllocateMemoryBlock(const size_t size, const size_t alignment = 16) {
+		inline MemoryBlock AllocateMemoryBlock(const size_t size, const size_t alignment = 16, const MemoryBlockFlags flags = MemoryBlockFlags::None) {
+			assert(size > 0);
+			assert((alignment > 0) && !(alignment & (alignment - 1)));
 			MemoryBlock result = {};
 			result.size = size;
+		#if defined(FPL_PLATFORM_WINDOWS) && defined(_DEBUG)
+			if (((uint32_t)flags & (uint32_t)MemoryBlockFlags::GuardPage) && (alignment <= 4096)) {
+				SYSTEM_INFO systemInfo;
+				GetSystemInfo(&systemInfo);
+				size_t pageSize = systemInfo.dwPageSize;
+				size_t usableSize = ((size + pageSize - 1) / pageSize) * pageSize;
+				uint8_t *allocation = (uint8_t *)VirtualAlloc(0, usableSize + pageSize, MEM_COMMIT | MEM_RESERVE, PAGE_READWRITE);
+				if (allocation != nullptr) {
+					DWORD oldProtect;
+					VirtualProtect(allocation + usableSize, pageSize, PAGE_NOACCESS, &oldProtect);
+					// The block ends at the guard page, only the alignment may leave a few bytes between
+					uintptr_t base = (uintptr_t)(allocation + usableSize - size);
+					base &= ~((uintptr_t)alignment - 1);
+					result.base = (void *)base;
+					result.guardAllocation = allocation;
+					return(result);
+				}
+			}
+		#endif
 			result.base = fpl::memory::MemoryAlignedAllocate(size, alignment);
 			return(result);
 		}
 
 		inline void ReleaseMemoryBlock(MemoryBlock *block) {
+			assert(block->temporaryCount == 0);
+		#if defined(FPL_PLATFORM_WINDOWS)
+			if (block->guardAllocation != nullptr) {
+				VirtualFree(block->guardAllocation, 0, MEM_RELEASE);
+				*block = {};
+				return;
+			}
+		#endif
 			if (block->base != nullptr) {
 				fpl::memory::MemoryAlignedFree(block->base);
 			}
 			*block = {};
 		}
 
+		// Pops everything from the block, the memory stays allocated
+		inline void ClearMemoryBlock(MemoryBlock *block) {
+			assert(block->temporaryCount == 0);
+			block->offset = 0;
+		}
+
+		inline size_t GetAlignmentOffset(const MemoryBlock *block, const size_t alignment) {
+			assert((alignment > 0) && !(alignment & (alignment - 1)));
+			uintptr_t address = (uintptr_t)block->base + block->offset;
+			uintptr_t mask = (uintptr_t)alignment - 1;
+			size_t result = (address & mask) ? (size_t)(alignment - (address & mask)) : 0;
+			return(result);
+		}
+
+		inline size_t GetRemainingSize(const MemoryBlock *block, const size_t alignment = 1) {
+			size_t alignmentOffset = GetAlignmentOffset(block, alignment);
+			size_t usedSize = block->offset + alignmentOffset;
+			size_t result = usedSize < block->size ? block->size - usedSize : 0;
+			return(result);
+		}
+
+		// @NOTE: The default alignment of one keeps pushes tightly packed, use a larger alignment for SIMD or cache line aligned data
 		template <typename T>
-		inline T *PushSize(MemoryBlock *block, const size_t size, const bool clear = true) {
-			assert((block->offset + size) <= block->size);
-			void *ptr = (void *)((uint8_t *)block->base + block->offset);
-			block->offset += size;
+		inline T *PushSize(MemoryBlock *block, const size_t size, const bool clear = true, const size_t alignment = 1) {
+			size_t alignmentOffset = GetAlignmentOffset(block, alignment);
+			assert((block->offset + alignmentOffset + size) <= block->size);
+			void *ptr = (void *)((uint8_t *)block->base + block->offset + alignmentOffset);
+			block->offset += alignmentOffset + size;
 			if (clear) {
-				fpl::memory::ClearMemory(ptr, size);
+				fpl::memory::MemoryClear(ptr, size);
 			}
 			T *result = (T*)ptr;
 			return(result);
 		}
 
 		template <typename T>
-		inline T *PushStruct(MemoryBlock *block, const bool clear = true) {
-			T *result = PushSize<T>(block, sizeof(T), clear);
+		inline T *PushStruct(MemoryBlock *block, const bool clear = true, const size_t alignment = 1) {
+			T *result = PushSize<T>(block, sizeof(T), clear, alignment);
 			return(result);
 		}
 
 		template <typename T>
-		inline T *PushArray(MemoryBlock *block, const size_t count, const bool clear = true) {
-			T *result = PushSize<T>(block, count * sizeof(T), clear);
+		inline T *PushArray(MemoryBlock *block, const size_t count, const bool clear = true, const size_t alignment = 1) {
+			T *result = PushSize<T>(block, count * sizeof(T), clear, alignment);
 			return(result);
 		}
 
 		inline void PopSize(MemoryBlock *block, const size_t size) {
-			assert((block->offset - size) >= 0);
+			assert(size <= block->offset);
 			block->offset -= size;
 		}
+
+		inline TemporaryMemory BeginTemporaryMemory(MemoryBlock *block) {
+			TemporaryMemory result = {};
+			result.block = block;
+			result.offset = block->offset;
+			++block->temporaryCount;
+			return(result);
+		}
+
+		inline void EndTemporaryMemory(TemporaryMemory *temp) {
+			MemoryBlock *block = temp->block;
+			assert(block->temporaryCount > 0);
+			assert(block->offset >= temp->offset);
+			block->offset = temp->offset;
+			--block->temporaryCount;
+			*temp = {};
+		}
 	};
 };
\ No newline at end of file
@@ -25,44 +25,125 @@ namespace fs {
 			return(result);
 		}
 
+		RenderVertex *OpenGLRenderer::PushBatchVertices(const BatchPrimitive primitive, void *textureHandle, const f32 lineWidth, const u32 vertexCount) {
+			// @NOTE: Consecutive primitives with the same state are merged into one batch.
+			// We never reorder across batches, so the submission order (and therefore blending) stays intact.
+			RenderBatch *batch = batches.empty() ? nullptr : &batches[batches.size() - 1];
+			if ((batch == nullptr) || (batch->primitive != primitive) || (batch->textureHandle != textureHandle) || (batch->lineWidth != lineWidth)) {
+				RenderBatch newBatch = {};
+				newBatch.primitive = primitive;
+				newBatch.textureHandle = textureHandle;
+				newBatch.lineWidth = lineWidth;
+				newBatch.firstVertex = (u32)batchVertices.size();
+				batches.emplace_back(newBatch);
+				batch = &batches[batches.size() - 1];
+			}
+			u32 firstVertex = (u32)batchVertices.size();
+			batchVertices.resize(firstVertex + vertexCount);
+			batch->vertexCount += vertexCount;
+			RenderVertex *result = &batchVertices[firstVertex];
+			return(result);
+		}
+
+		void OpenGLRenderer::FlushBatches() {
+			if (batches.size() > 0) {
+				// Vertices are already in world space, so we need the view projection only once
+				glLoadMatrixf(&viewProjection.m[0]);
+
+				const RenderVertex *firstVertex = &batchVertices[0];
+				glEnableClientState(GL_VERTEX_ARRAY);
+				glEnableClientState(GL_TEXTURE_COORD_ARRAY);
+				glEnableClientState(GL_COLOR_ARRAY);
+				glVertexPointer(2, GL_FLOAT, sizeof(RenderVertex), &firstVertex->position.elements[0]);
+				glTexCoordPointer(2, GL_FLOAT, sizeof(RenderVertex), &firstVertex->texcoord.elements[0]);
+				glColorPointer(4, GL_FLOAT, sizeof(RenderVertex), &firstVertex->color.elements[0]);
+
+				for (u32 batchIndex = 0; batchIndex < batches.size(); ++batchIndex) {
+					const RenderBatch &batch = batches[batchIndex];
+					if (batch.textureHandle != nullptr) {
+						GLuint texHandle = utils::PointerToValue<GLuint>(batch.textureHandle);
+						glEnable(GL_TEXTURE_2D);
+						glBindTexture(GL_TEXTURE_2D, texHandle);
+					} else {
+						glDisable(GL_TEXTURE_2D);
+					}
+
+					GLenum mode;
+					switch (batch.primitive) {
+						case BatchPrimitive::Quads:
+							mode = GL_QUADS;
+							break;
+						case BatchPrimitive::Triangles:
+							mode = GL_TRIANGLES;
+							break;
+						default:
+							mode = GL_LINES;
+							break;
+					}
+
+					glLineWidth(batch.lineWidth);
+					glDrawArrays(mode, (GLint)batch.firstVertex, (GLsizei)batch.vertexCount);
+
+					if (batch.textureHandle != nullptr) {
+						glBindTexture(GL_TEXTURE_2D, 0);
+						glDisable(GL_TEXTURE_2D);
+					}
+				}
+				glLineWidth(1.0f);
+
+				glDisableClientState(GL_COLOR_ARRAY);
+				glDisableClientState(GL_TEXTURE_COORD_ARRAY);
+				glDisableClientState(GL_VERTEX_ARRAY);
+			}
+			batches.clear();
+			batchVertices.clear();
+		}
+
 		void OpenGLRenderer::BeginFrame() {
 			glViewport(viewport.offset.x, viewport.offset.y, viewport.size.w, viewport.size.h);
 
 			glClear(GL_COLOR_BUFFER_BIT | GL_DEPTH_BUFFER_BIT);
+
+			batches.clear();
+			batchVertices.clear();
 		}
 
 		void OpenGLRenderer::EndFrame() {
+			FlushBatches();
 		}
 
 		void OpenGLRenderer::Update(const f32 halfGameWidth, const f32 halfGameHeight, const f32 aspectRatio) {
-			// Calculate a letterboxed viewport offset and size
-			viewSize = Vec2f(halfGameWidth, halfGameHeight) * 2.0f;
-			viewScale = (f32)windowSize.w / (halfGameWidth * 2.0f);
-			Vec2i viewportSize = Vec2i(windowSize.w, (u32)(windowSize.w / aspectRatio));
-			if (viewportSize.h > windowSize.h) {
-				viewportSize.h = windowSize.h;
-				viewportSize.w = (u32)(viewportSize.h * aspectRatio);
-				viewScale = (f32)viewportSize.w / (halfGameWidth * 2.0f);
-			}
-			Vec2i viewportOffset = Vec2i((windowSize.w - viewportSize.w) / 2, (windowSize.h - viewportSize.h) / 2);
-			viewport.size = viewportSize;
-			viewport.offset = viewportOffset;
-
-			// Update view projection
-			Mat4f proj = Mat4f::CreateOrthoRH(-halfGameWidth, halfGameWidth, -halfGameHeight, halfGameHeight, 0.0f, 1.0f);
-			Mat4f model = Mat4f::Identity;
-			viewProjection = proj * model;
+			UpdateView(halfGameWidth, halfGameHeight, aspectRatio);
 		}
 
 		Vec2f OpenGLRenderer::Unproject(const Vec2i &windowPos) {
-			Vec2f result = Vec2f();
-			if (viewScale > 0) {
-				result.x = (f32)((windowPos.x - viewport.offset.x) / viewScale) - viewSize.w * 0.5f;
-				result.y = (f32)((windowPos.y - viewport.offset.y) / viewScale) - viewSize.h * 0.5f;
-			}
+			Vec2f result = UnprojectView(windowPos);
 			return(result);
 		}
+
 		void OpenGLRenderer::DrawRectangle(const Vec2f & pos, const Vec2f & ext, const Vec4f &color, const bool isFilled, const f32 lineWidth) {
+			if (isBatchingEnabled) {
+				Vec2f corners[4] = {
+					pos + Vec2f(ext.w, ext.h),
+					pos + Vec2f(-ext.w, ext.h),
+					pos + Vec2f(-ext.w, -ext.h),
+					pos + Vec2f(ext.w, -ext.h),
+				};
+				if (isFilled) {
+					RenderVertex *verts = PushBatchVertices(BatchPrimitive::Quads, nullptr, 1.0f, 4);
+					for (u32 cornerIndex = 0; cornerIndex < 4; ++cornerIndex) {
+						verts[cornerIndex] = { corners[cornerIndex], Vec2f(), color };
+					}
+				} else {
+					RenderVertex *verts = PushBatchVertices(BatchPrimitive::Lines, nullptr, lineWidth, 8);
+					for (u32 cornerIndex = 0; cornerIndex < 4; ++cornerIndex) {
+						verts[cornerIndex * 2 + 0] = { corners[cornerIndex], Vec2f(), color };
+						verts[cornerIndex * 2 + 1] = { corners[(cornerIndex + 1) % 4], Vec2f(), color };
+					}
+				}
+				return;
+			}
+
 			Mat4f translation = Mat4f::CreateTranslation(pos);
 			Mat4f mvp = viewProjection * translation;
 			glLoadMatrixf(&mvp.m[0]);
@@ -80,6 +161,15 @@ namespace fs {
 		}
 
 		void OpenGLRenderer::DrawSprite(const Vec2f &pos, const Vec2f &ext, const Vec4f &color, const Texture &texture, const Vec2f &uvMin, const Vec2f &uvMax) {
+			if (isBatchingEnabled) {
+				RenderVertex *verts = PushBatchVertices(BatchPrimitive::Quads, texture.handle, 1.0f, 4);
+				verts[0] = { pos + Vec2f(ext.w, ext.h), Vec2f(uvMax.x, uvMax.y), color };
+				verts[1] = { pos + Vec2f(-ext.w, ext.h), Vec2f(uvMin.x, uvMax.y), color };
+				verts[2] = { pos + Vec2f(-ext.w, -ext.h), Vec2f(uvMin.x, uvMin.y), color };
+				verts[3] = { pos + Vec2f(ext.w, -ext.h), Vec2f(uvMax.x, uvMin.y), color };
+				return;
+			}
+
 			Mat4f translation = Mat4f::CreateTranslation(pos);
 			Mat4f mvp = viewProjection * translation;
 			glLoadMatrixf(&mvp.m[0]);
@@ -100,6 +190,13 @@ namespace fs {
 		}
 
 		void OpenGLRenderer::DrawLine(const Vec2f &a, const Vec2f &b, const Vec4f &color, const f32 lineWidth) {
+			if (isBatchingEnabled) {
+				RenderVertex *verts = PushBatchVertices(BatchPrimitive::Lines, nullptr, lineWidth, 2);
+				verts[0] = { a, Vec2f(), color };
+				verts[1] = { b, Vec2f(), color };
+				return;
+			}
+
 			Mat4f mvp = viewProjection;
 			glLoadMatrixf(&mvp.m[0]);
 
@@ -117,6 +214,30 @@ namespace fs {
 
 			f32 radForSegment = TAU32 / (f32)segmentCount;
 
+			if (isBatchingEnabled) {
+				RenderVertex *verts;
+				if (isFilled) {
+					verts = PushBatchVertices(BatchPrimitive::Triangles, nullptr, 1.0f, segmentCount * 3);
+				} else {
+					verts = PushBatchVertices(BatchPrimitive::Lines, nullptr, lineWidth, segmentCount * 2);
+				}
+				Vec2f lastPoint = center + Vec2f(radius, 0.0f);
+				for (u32 segmentIndex = 1; segmentIndex <= segmentCount; ++segmentIndex) {
+					f32 rad = (f32)segmentIndex * radForSegment;
+					Vec2f point = center + Vec2f(Cosine(rad) * radius, Sine(rad) * radius);
+					if (isFilled) {
+						*verts++ = { center, Vec2f(), color };
+						*verts++ = { lastPoint, Vec2f(), color };
+						*verts++ = { point, Vec2f(), color };
+					} else {
+						*verts++ = { lastPoint, Vec2f(), color };
+						*verts++ = { point, Vec2f(), color };
+					}
+					lastPoint = point;
+				}
+				return;
+			}
+
 			Mat4f translation = Mat4f::CreateTranslation(center);
 			Mat4f mvp = viewProjection * translation;
 			glLoadMatrixf(&mvp.m[0]);
@@ -133,5 +254,39 @@ namespace fs {
 			glEnd();
 			glLineWidth(1.0f);
 		}
+
+		void OpenGLRenderer::DrawQuads(const RenderVertex *vertices, const u32 vertexCount, const Texture &texture) {
+			assert((vertexCount % 4) == 0);
+			if (vertexCount == 0) {
+				return;
+			}
+
+			if (isBatchingEnabled) {
+				RenderVertex *verts = PushBatchVertices(BatchPrimitive::Quads, texture.handle, 1.0f, vertexCount);
+				for (u32 vertexIndex = 0; vertexIndex < vertexCount; ++vertexIndex) {
+					verts[vertexIndex] = vertices[vertexIndex];
+				}
+				return;
+			}
+
+			glLoadMatrixf(&viewProjection.m[0]);
+
+			GLuint texHandle = utils::PointerToValue<GLuint>(texture.handle);
+			glEnable(GL_TEXTURE_2D);
+			glBindTexture(GL_TEXTURE_2D, texHandle);
+
+			glEnableClientState(GL_VERTEX_ARRAY);
+			glEnableClientState(GL_TEXTURE_COORD_ARRAY);
+			glEnableClientState(GL_COLOR_ARRAY);
+			glVertexPointer(2, GL_FLOAT, sizeof(RenderVertex), &vertices->position.elements[0]);
+			glTexCoordPointer(2, GL_FLOAT, sizeof(RenderVertex), &vertices->texcoord.elements[0]);
+			glColorPointer(4, GL_FLOAT, sizeof(RenderVertex), &vertices->color.elements[0]);
+			glDrawArrays(GL_QUADS, 0, (GLsizei)vertexCount);
+			glDisableClientState(GL_COLOR_ARRAY);
+			glDisableClientState(GL_TEXTURE_COORD_ARRAY);
+			glDisableClientState(GL_VERTEX_ARRAY);
+
+			glBindTexture(GL_TEXTURE_2D, 0);
+		}
 	}
 }
\ No newline at end of file
@@ -1,12 +1,34 @@
 #pragma once
 
+#include <vector>
+
 #include <final_platform_layer.hpp>
 #include "final_types.h"
 #include "final_renderer.h"
 
 namespace fs {
 	namespace renderer {
+		enum class BatchPrimitive {
+			Quads,
+			Triangles,
+			Lines,
+		};
+
+		struct RenderBatch {
+			void *textureHandle;
+			BatchPrimitive primitive;
+			f32 lineWidth;
+			u32 firstVertex;
+			u32 vertexCount;
+		};
+
 		class OpenGLRenderer : public Renderer {
+		private:
+			std::vector<RenderVertex> batchVertices;
+			std::vector<RenderBatch> batches;
+
+			RenderVertex *PushBatchVertices(const BatchPrimitive primitive, void *textureHandle, const f32 lineWidth, const u32 vertexCount);
+			void FlushBatches();
 		public:
 			void *AllocateTexture(const u32 width, const u32 height, void *data) override;
 			void BeginFrame() override;
@@ -17,10 +39,11 @@ namespace fs {
 			void DrawRectangle(const Vec2f &pos, const Vec2f &ext, const Vec4f &color, const bool isFilled, const f32 lineWidth) override;
 			void DrawLine(const Vec2f &a, const Vec2f &b, const Vec4f &color, const f32 lineWidth) override;
 			void DrawCircle(const Vec2f &center, const f32 radius, const Vec4f &color, const bool isFilled, const u32 segmentCount, const f32 lineWidth) override;
+			void DrawQuads(const RenderVertex *vertices, const u32 vertexCount, const Texture &texture) override;
 			OpenGLRenderer() : Renderer() {
 			}
 			~OpenGLRenderer() {
 			};
 		};
 	};
-};
\ No newline at end of file
+};
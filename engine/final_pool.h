@@ -0,0 +1,171 @@
+#pragma once
+
+#include <new>
+
+#include "final_types.h"
+#include "final_mem.h"
+
+namespace fs {
+	namespace mem {
+		// Handle to a item in a Pool, which gets invalid as soon as the item is removed - even when the slot is used again.
+		// @NOTE: A zero handle is never valid, so a cleared handle can be used as a null handle.
+		struct PoolHandle {
+			u32 index;
+			u32 generation;
+		};
+
+		inline bool operator ==(const PoolHandle &a, const PoolHandle &b) {
+			bool result = (a.index == b.index) && (a.generation == b.generation);
+			return(result);
+		}
+		inline bool operator !=(const PoolHandle &a, const PoolHandle &b) {
+			bool result = !(a == b);
+			return(result);
+		}
+
+		// Fixed size pool with O(1) add and remove, items never move so pointers are stable until the item is removed.
+		// Items are visited in slot order, which is the order in which the items are added as long as nothing was removed.
+		// @NOTE: The generation of a slot is odd while the slot is used and even while it is free.
+		template <typename T>
+		class Pool {
+		private:
+			static constexpr u32 NO_SLOT = U32_MAX;
+
+			MemoryBlock memory;
+			T *items;
+			u32 *generations;
+			u32 *nextFreeSlots;
+			u32 capacity;
+			u32 count;
+			// Number of slots ever used since the last clear, all slots above are free
+			u32 slotCount;
+			u32 firstFreeSlot;
+		public:
+			Pool() :
+				memory({}),
+				items(nullptr),
+				generations(nullptr),
+				nextFreeSlots(nullptr),
+				capacity(0),
+				count(0),
+				slotCount(0),
+				firstFreeSlot(NO_SLOT) {
+			}
+			~Pool() {
+				Release();
+			}
+			Pool(const Pool &) = delete;
+			Pool &operator =(const Pool &) = delete;
+
+			void Init(const u32 capacity) {
+				assert(items == nullptr);
+				assert(capacity > 0);
+				size_t memorySize = (sizeof(T) + 16) * capacity + sizeof(u32) * capacity * 2 + 64;
+				memory = AllocateMemoryBlock(memorySize);
+				items = PushArray<T>(&memory, capacity, false, 16);
+				generations = PushArray<u32>(&memory, capacity, true, 16);
+				nextFreeSlots = PushArray<u32>(&memory, capacity, false, 16);
+				this->capacity = capacity;
+				count = 0;
+				slotCount = 0;
+				firstFreeSlot = NO_SLOT;
+			}
+
+			void Release() {
+				if (items != nullptr) {
+					Clear();
+					ReleaseMemoryBlock(&memory);
+					items = nullptr;
+					generations = nullptr;
+					nextFreeSlots = nullptr;
+					capacity = 0;
+				}
+			}
+
+			// Removes all items, the handles of these items stays invalid
+			void Clear() {
+				for (u32 slotIndex = 0; slotIndex < slotCount; ++slotIndex) {
+					if (IsSlotUsed(slotIndex)) {
+						items[slotIndex].~T();
+						++generations[slotIndex];
+					}
+				}
+				count = 0;
+				slotCount = 0;
+				firstFreeSlot = NO_SLOT;
+			}
+
+			PoolHandle Add(const T &value) {
+				assert(count < capacity);
+				u32 slotIndex;
+				if (firstFreeSlot != NO_SLOT) {
+					slotIndex = firstFreeSlot;
+					firstFreeSlot = nextFreeSlots[slotIndex];
+				} else {
+					slotIndex = slotCount++;
+				}
+				assert(!IsSlotUsed(slotIndex));
+				new (items + slotIndex) T(value);
+				++generations[slotIndex];
+				++count;
+				PoolHandle result = { slotIndex, generations[slotIndex] };
+				return(result);
+			}
+
+			void Remove(const PoolHandle &handle) {
+				assert(IsValid(handle));
+				u32 slotIndex = handle.index;
+				items[slotIndex].~T();
+				++generations[slotIndex];
+				nextFreeSlots[slotIndex] = firstFreeSlot;
+				firstFreeSlot = slotIndex;
+				--count;
+			}
+
+			inline bool IsValid(const PoolHandle &handle) const {
+				bool result = (handle.index < slotCount) && (handle.generation & 1) && (generations[handle.index] == handle.generation);
+				return(result);
+			}
+
+			// Returns the item or null when the handle is not valid anymore
+			inline T *Get(const PoolHandle &handle) {
+				T *result = IsValid(handle) ? &items[handle.index] : nullptr;
+				return(result);
+			}
+			inline const T *Get(const PoolHandle &handle) const {
+				const T *result = IsValid(handle) ? &items[handle.index] : nullptr;
+				return(result);
+			}
+
+			inline u32 GetCount() const {
+				return count;
+			}
+			inline u32 GetCapacity() const {
+				return capacity;
+			}
+
+			// Upper bound for iterating over the slots, unused slots must be skipped with IsSlotUsed()
+			inline u32 GetSlotCount() const {
+				return slotCount;
+			}
+			inline bool IsSlotUsed(const u32 slotIndex) const {
+				assert(slotIndex < capacity);
+				bool result = (generations[slotIndex] & 1) != 0;
+				return(result);
+			}
+			inline T &GetSlot(const u32 slotIndex) {
+				assert(IsSlotUsed(slotIndex));
+				return items[slotIndex];
+			}
+			inline const T &GetSlot(const u32 slotIndex) const {
+				assert(IsSlotUsed(slotIndex));
+				return items[slotIndex];
+			}
+			inline PoolHandle GetSlotHandle(const u32 slotIndex) const {
+				assert(IsSlotUsed(slotIndex));
+				PoolHandle result = { slotIndex, generations[slotIndex] };
+				return(result);
+			}
+		};
+	};
+};
\ No newline at end of file
@@ -0,0 +1,446 @@
+#include "final_rendercommands.h"
+
+#include <final_platform_layer.hpp>
+
+#include "final_utils.h"
+
+namespace fs {
+	namespace renderer {
+		static constexpr char RENDER_COMMANDS_MAGIC_ID[4] = { 'f', 'r', 'c', 'b' };
+		static constexpr u32 RENDER_COMMANDS_VERSION = 1;
+
+		CommandBufferRenderer::CommandBufferRenderer(Renderer *backend, const size_t capacity) :
+			Renderer(),
+			backend(backend),
+			submittedCommandCount(0),
+			submittedCommandSize(0) {
+			assert(backend != nullptr);
+			buffer = {};
+			buffer.memory = mem::AllocateMemoryBlock(capacity);
+		}
+
+		CommandBufferRenderer::~CommandBufferRenderer() {
+			ReleaseRenderCommands(&buffer);
+			textures.clear();
+		}
+
+		void CommandBufferRenderer::GrowBuffer(const size_t requiredSize) {
+			// @NOTE: Commands are written right after they are pushed, so no pointer into the old memory is kept and we can simply move it
+			size_t newCapacity = buffer.memory.size * 2;
+			while (newCapacity < buffer.memory.offset + requiredSize) {
+				newCapacity *= 2;
+			}
+			mem::MemoryBlock newMemory = mem::AllocateMemoryBlock(newCapacity);
+			if (buffer.memory.offset > 0) {
+				fpl::memory::MemoryCopy(buffer.memory.base, buffer.memory.offset, newMemory.base);
+			}
+			newMemory.offset = buffer.memory.offset;
+			mem::ReleaseMemoryBlock(&buffer.memory);
+			buffer.memory = newMemory;
+		}
+
+		void *CommandBufferRenderer::PushCommand(const RenderCommandType type, const u32 size) {
+			const size_t requiredSize = sizeof(RenderCommandHeader) + size;
+			if ((buffer.memory.offset + requiredSize) > buffer.memory.size) {
+				GrowBuffer(requiredSize);
+			}
+			// @NOTE: Commands are tightly packed without any alignment, because the replay steps over them by their header size only
+			RenderCommandHeader *header = mem::PushStruct<RenderCommandHeader>(&buffer.memory, false, 1);
+			header->type = type;
+			header->size = size;
+			void *result = nullptr;
+			if (size > 0) {
+				result = mem::PushSize<void>(&buffer.memory, size, false, 1);
+			}
+			++buffer.commandCount;
+			return(result);
+		}
+
+		void *CommandBufferRenderer::AllocateTexture(const u32 width, const u32 height, void *data) {
+			// @NOTE: Textures are resources, not commands - they are created on the backend right away.
+			// We keep a copy of the pixels, so a saved command buffer can be replayed without the original assets.
+			void *result = backend->AllocateTexture(width, height, data);
+			RecordedTexture texture = {};
+			texture.recordedHandle = utils::PointerToValue<u64>(result);
+			texture.replayHandle = result;
+			texture.width = width;
+			texture.height = height;
+			if (data != nullptr) {
+				const u8 *pixels = (const u8 *)data;
+				texture.pixels.assign(pixels, pixels + (width * height * 4));
+			}
+			textures.emplace_back(texture);
+			return(result);
+		}
+
+		void CommandBufferRenderer::BeginFrame() {
+			PushCommand(RenderCommandType::BeginFrame, 0);
+		}
+
+		void CommandBufferRenderer::EndFrame() {
+			PushCommand(RenderCommandType::EndFrame, 0);
+		}
+
+		void CommandBufferRenderer::Update(const f32 halfGameWidth, const f32 halfGameHeight, const f32 aspectRatio) {
+			// The game needs the viewport and the projection immediately (Unproject etc.), so we let the backend compute it
+			backend->windowSize = windowSize;
+			backend->Update(halfGameWidth, halfGameHeight, aspectRatio);
+			viewProjection = backend->viewProjection;
+			viewport = backend->viewport;
+			viewScale = backend->viewScale;
+			viewSize = backend->viewSize;
+
+			RenderCommandUpdate *command = (RenderCommandUpdate *)PushCommand(RenderCommandType::Update, sizeof(RenderCommandUpdate));
+			command->windowSize = windowSize;
+			command->halfGameWidth = halfGameWidth;
+			command->halfGameHeight = halfGameHeight;
+			command->aspectRatio = aspectRatio;
+		}
+
+		Vec2f CommandBufferRenderer::Unproject(const Vec2i &windowPos) {
+			Vec2f result = backend->Unproject(windowPos);
+			return(result);
+		}
+
+		void CommandBufferRenderer::DrawSprite(const Vec2f &pos, const Vec2f &ext, const Vec4f &color, const Texture &texture, const Vec2f &uvMin, const Vec2f &uvMax) {
+			RenderCommandSprite *command = (RenderCommandSprite *)PushCommand(RenderCommandType::Sprite, sizeof(RenderCommandSprite));
+			command->pos = pos;
+			command->ext = ext;
+			command->color = color;
+			command->uvMin = uvMin;
+			command->uvMax = uvMax;
+			command->textureHandle = utils::PointerToValue<u64>(texture.handle);
+			command->textureWidth = texture.width;
+			command->textureHeight = texture.height;
+		}
+
+		void CommandBufferRenderer::DrawRectangle(const Vec2f &pos, const Vec2f &ext, const Vec4f &color, const bool isFilled, const f32 lineWidth) {
+			RenderCommandRectangle *command = (RenderCommandRectangle *)PushCommand(RenderCommandType::Rectangle, sizeof(RenderCommandRectangle));
+			command->pos = pos;
+			command->ext = ext;
+			command->color = color;
+			command->isFilled = isFilled;
+			command->lineWidth = lineWidth;
+		}
+
+		void CommandBufferRenderer::DrawLine(const Vec2f &a, const Vec2f &b, const Vec4f &color, const f32 lineWidth) {
+			RenderCommandLine *command = (RenderCommandLine *)PushCommand(RenderCommandType::Line, sizeof(RenderCommandLine));
+			command->a = a;
+			command->b = b;
+			command->color = color;
+			command->lineWidth = lineWidth;
+		}
+
+		void CommandBufferRenderer::DrawCircle(const Vec2f &center, const f32 radius, const Vec4f &color, const bool isFilled, const u32 segmentCount, const f32 lineWidth) {
+			RenderCommandCircle *command = (RenderCommandCircle *)PushCommand(RenderCommandType::Circle, sizeof(RenderCommandCircle));
+			command->center = center;
+			command->radius = radius;
+			command->color = color;
+			command->isFilled = isFilled;
+			command->segmentCount = segmentCount;
+			command->lineWidth = lineWidth;
+		}
+
+		void CommandBufferRenderer::DrawQuads(const RenderVertex *vertices, const u32 vertexCount, const Texture &texture) {
+			u32 commandSize = (u32)(sizeof(RenderCommandQuads) + sizeof(RenderVertex) * vertexCount);
+			RenderCommandQuads *command = (RenderCommandQuads *)PushCommand(RenderCommandType::Quads, commandSize);
+			command->textureHandle = utils::PointerToValue<u64>(texture.handle);
+			command->textureWidth = texture.width;
+			command->textureHeight = texture.height;
+			command->vertexCount = vertexCount;
+			RenderVertex *commandVertices = (RenderVertex *)(command + 1);
+			for (u32 vertexIndex = 0; vertexIndex < vertexCount; ++vertexIndex) {
+				commandVertices[vertexIndex] = vertices[vertexIndex];
+			}
+		}
+
+		void CommandBufferRenderer::Submit() {
+			if (!ReplayRenderCommands(buffer, backend)) {
+				assert(!"Invalid render command buffer!");
+			}
+
+			// @NOTE: We start over for the next frame, but the memory is left untouched so SaveToFile() still works
+			submittedCommandCount = buffer.commandCount;
+			submittedCommandSize = (u32)buffer.memory.offset;
+			buffer.memory.offset = 0;
+			buffer.commandCount = 0;
+		}
+
+		bool CommandBufferRenderer::SaveToFile(const char *filePath) {
+			bool result = false;
+			fpl::files::FileHandle fileHandle = fpl::files::CreateBinaryFile(filePath);
+			if (fileHandle.isValid) {
+				fpl::files::WriteFileBlock32(fileHandle, (void *)&RENDER_COMMANDS_MAGIC_ID, sizeof(RENDER_COMMANDS_MAGIC_ID));
+				u32 version = RENDER_COMMANDS_VERSION;
+				fpl::files::WriteFileBlock32(fileHandle, &version, sizeof(version));
+
+				u32 textureCount = (u32)textures.size();
+				fpl::files::WriteFileBlock32(fileHandle, &textureCount, sizeof(textureCount));
+				for (u32 textureIndex = 0; textureIndex < textureCount; ++textureIndex) {
+					RecordedTexture &texture = textures[textureIndex];
+					u32 pixelSize = (u32)texture.pixels.size();
+					fpl::files::WriteFileBlock32(fileHandle, &texture.recordedHandle, sizeof(texture.recordedHandle));
+					fpl::files::WriteFileBlock32(fileHandle, &texture.width, sizeof(texture.width));
+					fpl::files::WriteFileBlock32(fileHandle, &texture.height, sizeof(texture.height));
+					fpl::files::WriteFileBlock32(fileHandle, &pixelSize, sizeof(pixelSize));
+					if (pixelSize > 0) {
+						fpl::files::WriteFileBlock32(fileHandle, &texture.pixels[0], pixelSize);
+					}
+				}
+
+				u32 commandCount = submittedCommandCount;
+				u32 commandSize = submittedCommandSize;
+				fpl::files::WriteFileBlock32(fileHandle, &commandCount, sizeof(commandCount));
+				fpl::files::WriteFileBlock32(fileHandle, &commandSize, sizeof(commandSize));
+				if (commandSize > 0) {
+					fpl::files::WriteFileBlock32(fileHandle, buffer.memory.base, commandSize);
+				}
+
+				fpl::files::CloseFile(fileHandle);
+				result = true;
+			}
+			return(result);
+		}
+
+		static void *FindReplayTexture(const u64 recordedHandle, const RecordedTexture *textures, const u32 textureCount) {
+			void *result = utils::ValueToPointer(recordedHandle);
+			if (textures != nullptr) {
+				result = nullptr;
+				for (u32 textureIndex = 0; textureIndex < textureCount; ++textureIndex) {
+					if (textures[textureIndex].recordedHandle == recordedHandle) {
+						result = textures[textureIndex].replayHandle;
+						break;
+					}
+				}
+			}
+			return(result);
+		}
+
+		extern bool ReplayRenderCommands(const RenderCommandBuffer &buffer, Renderer *backend, const RecordedTexture *textures, const u32 textureCount) {
+			assert(backend != nullptr);
+			u8 *base = (u8 *)buffer.memory.base;
+			const size_t size = buffer.memory.offset;
+			size_t at = 0;
+			for (u32 commandIndex = 0; commandIndex < buffer.commandCount; ++commandIndex) {
+				// Stop before any command which does not fit into the buffer
+				if ((size - at) < sizeof(RenderCommandHeader)) {
+					return false;
+				}
+				RenderCommandHeader *header = (RenderCommandHeader *)(base + at);
+				if ((size - at - sizeof(RenderCommandHeader)) < header->size) {
+					return false;
+				}
+				void *data = base + at + sizeof(RenderCommandHeader);
+				switch (header->type) {
+					case RenderCommandType::Update:
+					{
+						RenderCommandUpdate *command = (RenderCommandUpdate *)data;
+						backend->windowSize = command->windowSize;
+						backend->Update(command->halfGameWidth, command->halfGameHeight, command->aspectRatio);
+					} break;
+					case RenderCommandType::BeginFrame:
+					{
+						backend->BeginFrame();
+					} break;
+					case RenderCommandType::EndFrame:
+					{
+						backend->EndFrame();
+					} break;
+					case RenderCommandType::Sprite:
+					{
+						RenderCommandSprite *command = (RenderCommandSprite *)data;
+						Texture texture = {};
+						texture.handle = FindReplayTexture(command->textureHandle, textures, textureCount);
+						texture.width = command->textureWidth;
+						texture.height = command->textureHeight;
+						backend->DrawSprite(command->pos, command->ext, command->color, texture, command->uvMin, command->uvMax);
+					} break;
+					case RenderCommandType::Rectangle:
+					{
+						RenderCommandRectangle *command = (RenderCommandRectangle *)data;
+						backend->DrawRectangle(command->pos, command->ext, command->color, command->isFilled > 0, command->lineWidth);
+					} break;
+					case RenderCommandType::Line:
+					{
+						RenderCommandLine *command = (RenderCommandLine *)data;
+						backend->DrawLine(command->a, command->b, command->color, command->lineWidth);
+					} break;
+					case RenderCommandType::Circle:
+					{
+						RenderCommandCircle *command = (RenderCommandCircle *)data;
+						backend->DrawCircle(command->center, command->radius, command->color, command->isFilled > 0, command->segmentCount, command->lineWidth);
+					} break;
+					case RenderCommandType::Quads:
+					{
+						RenderCommandQuads *command = (RenderCommandQuads *)data;
+						Texture texture = {};
+						texture.handle = FindReplayTexture(command->textureHandle, textures, textureCount);
+						texture.width = command->textureWidth;
+						texture.height = command->textureHeight;
+						backend->DrawQuads((const RenderVertex *)(command + 1), command->vertexCount, texture);
+					} break;
+					default:
+						return false;
+				}
+				at += sizeof(RenderCommandHeader) + header->size;
+			}
+			return true;
+		}
+
+		static bool ReadFileValue(const fpl::files::FileHandle &fileHandle, void *value, const u32 size) {
+			u32 read = fpl::files::ReadFileBlock32(fileHandle, size, value, size);
+			bool result = read == size;
+			return(result);
+		}
+
+		// Size of the command data for the given type or zero for types with variable size, returns false for unknown types
+		static bool GetRenderCommandDataSize(const RenderCommandType type, u32 *outSize) {
+			bool result = true;
+			switch (type) {
+				case RenderCommandType::Update:
+					*outSize = sizeof(RenderCommandUpdate);
+					break;
+				case RenderCommandType::BeginFrame:
+				case RenderCommandType::EndFrame:
+				case RenderCommandType::Quads:
+					*outSize = 0;
+					break;
+				case RenderCommandType::Sprite:
+					*outSize = sizeof(RenderCommandSprite);
+					break;
+				case RenderCommandType::Rectangle:
+					*outSize = sizeof(RenderCommandRectangle);
+					break;
+				case RenderCommandType::Line:
+					*outSize = sizeof(RenderCommandLine);
+					break;
+				case RenderCommandType::Circle:
+					*outSize = sizeof(RenderCommandCircle);
+					break;
+				default:
+					result = false;
+					break;
+			}
+			return(result);
+		}
+
+		// Walks over all commands once and checks that every command is known and lies completely inside the buffer
+		static bool IsValidRenderCommandBuffer(const RenderCommandBuffer &buffer) {
+			const u8 *base = (const u8 *)buffer.memory.base;
+			const size_t size = buffer.memory.offset;
+			size_t at = 0;
+			for (u32 commandIndex = 0; commandIndex < buffer.commandCount; ++commandIndex) {
+				if ((size - at) < sizeof(RenderCommandHeader)) {
+					return false;
+				}
+				const RenderCommandHeader *header = (const RenderCommandHeader *)(base + at);
+				at += sizeof(RenderCommandHeader);
+				if ((size - at) < header->size) {
+					return false;
+				}
+				u32 dataSize = 0;
+				if (!GetRenderCommandDataSize(header->type, &dataSize)) {
+					return false;
+				}
+				if (header->type == RenderCommandType::Quads) {
+					if (header->size < sizeof(RenderCommandQuads)) {
+						return false;
+					}
+					const RenderCommandQuads *command = (const RenderCommandQuads *)(base + at);
+					u64 quadsSize = sizeof(RenderCommandQuads) + (u64)command->vertexCount * sizeof(RenderVertex);
+					if (quadsSize > header->size) {
+						return false;
+					}
+				} else if (header->size != dataSize) {
+					return false;
+				}
+				at += header->size;
+			}
+			bool result = at == size;
+			return(result);
+		}
+
+		extern bool LoadRenderCommands(const char *filePath, RenderCommandBuffer *outBuffer, std::vector<RecordedTexture> &outTextures) {
+			assert(outBuffer != nullptr);
+			*outBuffer = {};
+			outTextures.clear();
+			bool result = false;
+			fpl::files::FileHandle fileHandle = fpl::files::OpenBinaryFile(filePath);
+			if (fileHandle.isValid) {
+				// @NOTE: The file may come from anywhere, so every size is checked against the file before anything is allocated or replayed
+				const u32 fileSize = fpl::files::GetFileSize32(fileHandle);
+				char magic[4] = {};
+				u32 version = 0;
+				u32 textureCount = 0;
+				if (ReadFileValue(fileHandle, magic, sizeof(magic)) &&
+					ReadFileValue(fileHandle, &version, sizeof(version)) &&
+					(strncmp(RENDER_COMMANDS_MAGIC_ID, magic, utils::ArrayCount(RENDER_COMMANDS_MAGIC_ID)) == 0) &&
+					(version == RENDER_COMMANDS_VERSION) &&
+					ReadFileValue(fileHandle, &textureCount, sizeof(textureCount))) {
+					// Each texture has a handle, the size and the pixel size at least
+					const u32 minTextureSize = sizeof(u64) + sizeof(u32) * 3;
+					bool isValid = (u64)textureCount * minTextureSize <= fileSize;
+					if (isValid) {
+						outTextures.resize(textureCount);
+					}
+					for (u32 textureIndex = 0; isValid && (textureIndex < textureCount); ++textureIndex) {
+						RecordedTexture &texture = outTextures[textureIndex];
+						u32 pixelSize = 0;
+						isValid = ReadFileValue(fileHandle, &texture.recordedHandle, sizeof(texture.recordedHandle)) &&
+							ReadFileValue(fileHandle, &texture.width, sizeof(texture.width)) &&
+							ReadFileValue(fileHandle, &texture.height, sizeof(texture.height)) &&
+							ReadFileValue(fileHandle, &pixelSize, sizeof(pixelSize));
+						// Textures without pixels are allowed, otherwise the backend reads exactly width * height RGBA pixels
+						u64 expectedPixelSize = (u64)texture.width * texture.height * 4;
+						isValid = isValid && (expectedPixelSize <= U32_MAX) && ((pixelSize == 0) || (pixelSize == expectedPixelSize)) && (pixelSize <= fileSize);
+						texture.replayHandle = nullptr;
+						if (isValid && (pixelSize > 0)) {
+							texture.pixels.resize(pixelSize);
+							isValid = ReadFileValue(fileHandle, &texture.pixels[0], pixelSize);
+						}
+					}
+
+					u32 commandCount = 0;
+					u32 commandSize = 0;
+					isValid = isValid &&
+						ReadFileValue(fileHandle, &commandCount, sizeof(commandCount)) &&
+						ReadFileValue(fileHandle, &commandSize, sizeof(commandSize)) &&
+						(commandSize <= fileSize);
+					if (isValid) {
+						outBuffer->memory = mem::AllocateMemoryBlock(commandSize > 0 ? commandSize : 1);
+						if (commandSize > 0) {
+							isValid = ReadFileValue(fileHandle, outBuffer->memory.base, commandSize);
+						}
+						outBuffer->memory.offset = commandSize;
+						outBuffer->commandCount = commandCount;
+						isValid = isValid && IsValidRenderCommandBuffer(*outBuffer);
+					}
+					result = isValid;
+				}
+				fpl::files::CloseFile(fileHandle);
+			}
+			if (!result) {
+				if (outBuffer->memory.base != nullptr) {
+					ReleaseRenderCommands(outBuffer);
+				}
+				*outBuffer = {};
+				outTextures.clear();
+			}
+			return(result);
+		}
+
+		extern void UploadRecordedTextures(Renderer *backend, RecordedTexture *textures, const u32 textureCount) {
+			assert(backend != nullptr);
+			for (u32 textureIndex = 0; textureIndex < textureCount; ++textureIndex) {
+				RecordedTexture &texture = textures[textureIndex];
+				void *pixels = texture.pixels.size() > 0 ? &texture.pixels[0] : nullptr;
+				texture.replayHandle = backend->AllocateTexture(texture.width, texture.height, pixels);
+			}
+		}
+
+		extern void ReleaseRenderCommands(RenderCommandBuffer *buffer) {
+			mem::ReleaseMemoryBlock(&buffer->memory);
+			buffer->commandCount = 0;
+		}
+	}
+}
@@ -0,0 +1,146 @@
+#pragma once
+
+#include <vector>
+
+#include "final_types.h"
+#include "final_maths.h"
+#include "final_mem.h"
+#include "final_renderer.h"
+
+namespace fs {
+	namespace renderer {
+		enum class RenderCommandType : u32 {
+			None = 0,
+			Update,
+			BeginFrame,
+			EndFrame,
+			Sprite,
+			Rectangle,
+			Line,
+			Circle,
+			Quads,
+		};
+
+		// @NOTE: All commands are POD and contains no pointers, so a command buffer can be written to disk as-is.
+		// Texture handles are stored as plain values and are remapped on replay.
+		struct RenderCommandHeader {
+			RenderCommandType type;
+			u32 size;
+		};
+
+		struct RenderCommandUpdate {
+			Vec2i windowSize;
+			f32 halfGameWidth;
+			f32 halfGameHeight;
+			f32 aspectRatio;
+		};
+
+		struct RenderCommandSprite {
+			Vec2f pos;
+			Vec2f ext;
+			Vec4f color;
+			Vec2f uvMin;
+			Vec2f uvMax;
+			u64 textureHandle;
+			u32 textureWidth;
+			u32 textureHeight;
+		};
+
+		struct RenderCommandRectangle {
+			Vec2f pos;
+			Vec2f ext;
+			Vec4f color;
+			f32 lineWidth;
+			b32 isFilled;
+		};
+
+		struct RenderCommandLine {
+			Vec2f a;
+			Vec2f b;
+			Vec4f color;
+			f32 lineWidth;
+		};
+
+		struct RenderCommandCircle {
+			Vec2f center;
+			Vec4f color;
+			f32 radius;
+			f32 lineWidth;
+			u32 segmentCount;
+			b32 isFilled;
+		};
+
+		// @NOTE: Followed by vertexCount vertices
+		struct RenderCommandQuads {
+			u64 textureHandle;
+			u32 textureWidth;
+			u32 textureHeight;
+			u32 vertexCount;
+		};
+
+		struct RenderCommandBuffer {
+			mem::MemoryBlock memory;
+			u32 commandCount;
+		};
+
+		struct RecordedTexture {
+			u64 recordedHandle;
+			void *replayHandle;
+			u32 width;
+			u32 height;
+			std::vector<u8> pixels;
+		};
+
+		// Renderer which records every call into a command buffer instead of drawing it.
+		// Textures are allocated on the backend immediately, everything else is deferred until Submit() is called.
+		class CommandBufferRenderer : public Renderer {
+		private:
+			Renderer *backend;
+			RenderCommandBuffer buffer;
+			std::vector<RecordedTexture> textures;
+			u32 submittedCommandCount;
+			u32 submittedCommandSize;
+
+			// Moves the commands into a larger block, which has room for at least requiredSize more bytes
+			void GrowBuffer(const size_t requiredSize);
+			void *PushCommand(const RenderCommandType type, const u32 size);
+		public:
+			void *AllocateTexture(const u32 width, const u32 height, void *data) override;
+			void BeginFrame() override;
+			void EndFrame() override;
+			void Update(const f32 halfGameWidth, const f32 halfGameHeight, const f32 aspectRatio) override;
+			Vec2f Unproject(const Vec2i &windowPos) override;
+			void DrawSprite(const Vec2f &pos, const Vec2f &ext, const Vec4f &color, const Texture &texture, const Vec2f &uvMin, const Vec2f &uvMax) override;
+			void DrawRectangle(const Vec2f &pos, const Vec2f &ext, const Vec4f &color, const bool isFilled, const f32 lineWidth) override;
+			void DrawLine(const Vec2f &a, const Vec2f &b, const Vec4f &color, const f32 lineWidth) override;
+			void DrawCircle(const Vec2f &center, const f32 radius, const Vec4f &color, const bool isFilled, const u32 segmentCount, const f32 lineWidth) override;
+			void DrawQuads(const RenderVertex *vertices, const u32 vertexCount, const Texture &texture) override;
+
+			// Replays all recorded commands on the backend
+			void Submit();
+			// Writes the commands from the last submitted frame including all textures to the given file
+			bool SaveToFile(const char *filePath);
+
+			inline const RenderCommandBuffer &GetBuffer() const {
+				return buffer;
+			}
+			inline u32 GetSubmittedCommandCount() const {
+				return submittedCommandCount;
+			}
+			inline u32 GetSubmittedCommandSize() const {
+				return submittedCommandSize;
+			}
+
+			// The capacity is just the initial size, the buffer grows when a frame needs more
+			CommandBufferRenderer(Renderer *backend, const size_t capacity = 4 * 1024 * 1024);
+			~CommandBufferRenderer();
+		};
+
+		// Replays the commands on the backend, stops and returns false on a unknown command or a command which does not fit into the buffer
+		extern bool ReplayRenderCommands(const RenderCommandBuffer &buffer, Renderer *backend, const RecordedTexture *textures = nullptr, const u32 textureCount = 0);
+		// Loads a file written by SaveToFile(), returns false and leaves the buffer and textures empty when any size or command in the file is invalid
+		extern bool LoadRenderCommands(const char *filePath, RenderCommandBuffer *outBuffer, std::vector<RecordedTexture> &outTextures);
+		extern void UploadRecordedTextures(Renderer *backend, RecordedTexture *textures, const u32 textureCount);
+		extern void ReleaseRenderCommands(RenderCommandBuffer *buffer);
+	};
+};
@@ -12,6 +12,12 @@ namespace fs {
 			u32 height;
 		};
 
+		struct RenderVertex {
+			Vec2f position;
+			Vec2f texcoord;
+			Vec4f color;
+		};
+
 		struct Viewport {
 			Vec2i offset;
 			Vec2i size;
@@ -99,12 +105,42 @@ namespace fs {
 		}
 
 		class Renderer {
+		protected:
+			// Calculates a letterboxed viewport and the view projection, so every backend shares the exact same mapping
+			inline void UpdateView(const f32 halfGameWidth, const f32 halfGameHeight, const f32 aspectRatio) {
+				viewSize = Vec2f(halfGameWidth, halfGameHeight) * 2.0f;
+				viewScale = (f32)windowSize.w / (halfGameWidth * 2.0f);
+				Vec2i viewportSize = Vec2i(windowSize.w, (u32)(windowSize.w / aspectRatio));
+				if (viewportSize.h > windowSize.h) {
+					viewportSize.h = windowSize.h;
+					viewportSize.w = (u32)(viewportSize.h * aspectRatio);
+					viewScale = (f32)viewportSize.w / (halfGameWidth * 2.0f);
+				}
+				Vec2i viewportOffset = Vec2i((windowSize.w - viewportSize.w) / 2, (windowSize.h - viewportSize.h) / 2);
+				viewport.size = viewportSize;
+				viewport.offset = viewportOffset;
+
+				Mat4f proj = Mat4f::CreateOrthoRH(-halfGameWidth, halfGameWidth, -halfGameHeight, halfGameHeight, 0.0f, 1.0f);
+				Mat4f model = Mat4f::Identity;
+				viewProjection = proj * model;
+			}
+
+			inline Vec2f UnprojectView(const Vec2i &windowPos) const {
+				Vec2f result = Vec2f();
+				if (viewScale > 0) {
+					result.x = (f32)((windowPos.x - viewport.offset.x) / viewScale) - viewSize.w * 0.5f;
+					result.y = (f32)((windowPos.y - viewport.offset.y) / viewScale) - viewSize.h * 0.5f;
+				}
+				return(result);
+			}
 		public:
 			Mat4f viewProjection;
 			Viewport viewport;
 			Vec2i windowSize;
 			f32 viewScale;
 			Vec2f viewSize;
+			// @NOTE: When enabled, primitives are collected into vertex batches and submitted in EndFrame()
+			bool isBatchingEnabled;
 			virtual void *AllocateTexture(const u32 width, const u32 height, void *data) = 0;
 			virtual void BeginFrame() = 0;
 			virtual void EndFrame() = 0;
@@ -114,7 +150,10 @@ namespace fs {
 			virtual void DrawRectangle(const Vec2f &pos, const Vec2f &ext, const Vec4f &color = Vec4f::White, const bool isFilled = true, const f32 lineWidth = 1.0f) = 0;
 			virtual void DrawLine(const Vec2f &a, const Vec2f &b, const Vec4f &color = Vec4f::White, const f32 lineWidth = 1.0f) = 0;
 			virtual void DrawCircle(const Vec2f &center, const f32 radius, const Vec4f &color = Vec4f::White, const bool isFilled = true, const u32 segmentCount = 16, const f32 lineWidth = 1.0f) = 0;
-			Renderer() {
+			// Draws textured quads in world space, four vertices per quad in the same order as DrawSprite()
+			virtual void DrawQuads(const RenderVertex *vertices, const u32 vertexCount, const Texture &texture) = 0;
+			Renderer() :
+				isBatchingEnabled(false) {
 			}
 			virtual ~Renderer() {
 			}
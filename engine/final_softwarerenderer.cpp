@@ -0,0 +1,503 @@
+#include "final_softwarerenderer.h"
+
+#include <math.h>
+#include <string.h>
+
+#if MATH_ENABLE_SSE2
+#	include <emmintrin.h>
+#endif
+
+#include "final_utils.h"
+
+namespace fs {
+	namespace renderer {
+		//
+		// Pixel operations
+		//
+		// @NOTE: The scalar and the SSE2 path must use the exact same integer math, otherwise the results depends on the span alignment
+		inline u32 Div255(const u32 value) {
+			u32 x = value + 128;
+			u32 result = (x + (x >> 8)) >> 8;
+			return(result);
+		}
+
+		inline u32 PackColor(const Vec4f &color) {
+			u8 r = (u8)(Clamp(color.x, 0.0f, 1.0f) * 255.0f + 0.5f);
+			u8 g = (u8)(Clamp(color.y, 0.0f, 1.0f) * 255.0f + 0.5f);
+			u8 b = (u8)(Clamp(color.z, 0.0f, 1.0f) * 255.0f + 0.5f);
+			u8 a = (u8)(Clamp(color.w, 0.0f, 1.0f) * 255.0f + 0.5f);
+			u32 result = RGBA(r, g, b, a);
+			return(result);
+		}
+
+		inline u32 ModulatePixel(const u32 texel, const u32 color) {
+			u32 result = 0;
+			for (u32 shift = 0; shift < 32; shift += 8) {
+				u32 t = (texel >> shift) & 0xFF;
+				u32 c = (color >> shift) & 0xFF;
+				result |= Div255(t * c) << shift;
+			}
+			return(result);
+		}
+
+		// Same as glBlendFunc(GL_SRC_ALPHA, GL_ONE_MINUS_SRC_ALPHA), applied to all four channels
+		inline u32 BlendPixel(const u32 dst, const u32 src) {
+			u32 a = src >> 24;
+			if (a == 255) {
+				return(src);
+			}
+			if (a == 0) {
+				return(dst);
+			}
+			u32 invA = 255 - a;
+			u32 result = 0;
+			for (u32 shift = 0; shift < 32; shift += 8) {
+				u32 s = (src >> shift) & 0xFF;
+				u32 d = (dst >> shift) & 0xFF;
+				result |= Div255(d * invA + s * a) << shift;
+			}
+			return(result);
+		}
+
+		static void StoreSpan(u32 *dst, const u32 count, const u32 color) {
+			u32 index = 0;
+#if MATH_ENABLE_SSE2
+			__m128i color4 = _mm_set1_epi32((int)color);
+			for (; index + 4 <= count; index += 4) {
+				_mm_storeu_si128((__m128i *)(dst + index), color4);
+			}
+#endif
+			for (; index < count; ++index) {
+				dst[index] = color;
+			}
+		}
+
+		static void FillSpan(u32 *dst, const u32 count, const u32 color) {
+			u32 a = color >> 24;
+			if (a == 0) {
+				return;
+			}
+			if (a == 255) {
+				StoreSpan(dst, count, color);
+				return;
+			}
+			u32 index = 0;
+#if MATH_ENABLE_SSE2
+			// Blends four pixels at once with 16-bit lanes: d * (255 - a) + s * a + 128
+			__m128i zero = _mm_setzero_si128();
+			__m128i src = _mm_unpacklo_epi8(_mm_set1_epi32((int)color), zero);
+			__m128i srcTerm = _mm_add_epi16(_mm_mullo_epi16(src, _mm_set1_epi16((short)a)), _mm_set1_epi16(128));
+			__m128i invA = _mm_set1_epi16((short)(255 - a));
+			for (; index + 4 <= count; index += 4) {
+				__m128i d = _mm_loadu_si128((__m128i *)(dst + index));
+				__m128i lo = _mm_add_epi16(_mm_mullo_epi16(_mm_unpacklo_epi8(d, zero), invA), srcTerm);
+				__m128i hi = _mm_add_epi16(_mm_mullo_epi16(_mm_unpackhi_epi8(d, zero), invA), srcTerm);
+				lo = _mm_srli_epi16(_mm_add_epi16(lo, _mm_srli_epi16(lo, 8)), 8);
+				hi = _mm_srli_epi16(_mm_add_epi16(hi, _mm_srli_epi16(hi, 8)), 8);
+				_mm_storeu_si128((__m128i *)(dst + index), _mm_packus_epi16(lo, hi));
+			}
+#endif
+			for (; index < count; ++index) {
+				dst[index] = BlendPixel(dst[index], color);
+			}
+		}
+
+		//
+		// Triangle edges
+		//
+		struct SoftwareEdge {
+			f32 a;
+			f32 b;
+			f32 c;
+			bool isOwner;
+
+			inline bool IsInside(const f32 x, const f32 y) const {
+				f32 e = a * x + b * y + c;
+				bool result = (e > 0.0f) || ((e == 0.0f) && isOwner);
+				return(result);
+			}
+		};
+
+		inline SoftwareEdge MakeEdge(const Vec2f &p, const Vec2f &q) {
+			SoftwareEdge result;
+			result.a = -(q.y - p.y);
+			result.b = q.x - p.x;
+			result.c = -(result.a * p.x + result.b * p.y);
+			// @NOTE: Shared edges are visited in opposite directions by its two triangles, so exactly one of them owns the pixels on it.
+			// This prevents double blending on triangle fans (circles) and thick lines.
+			result.isOwner = (q.y < p.y) || ((q.y == p.y) && (q.x > p.x));
+			return(result);
+		}
+
+		//
+		// SoftwareRenderer
+		//
+		SoftwareRenderer::SoftwareRenderer(const u32 width, const u32 height) :
+			Renderer(),
+			tileCountX(0),
+			tileCountY(0),
+			workerPool(nullptr),
+			clearColor(RGBA(0, 0, 0, 255)) {
+			framebuffer = {};
+			windowSize = Vec2i(width, height);
+			ResizeFramebuffer(width, height);
+		}
+
+		SoftwareRenderer::~SoftwareRenderer() {
+			mem::ReleaseMemoryBlock(&framebuffer.memory);
+		}
+
+		void SoftwareRenderer::ResizeFramebuffer(const u32 width, const u32 height) {
+			if ((framebuffer.width != width) || (framebuffer.height != height)) {
+				mem::ReleaseMemoryBlock(&framebuffer.memory);
+				framebuffer = {};
+				framebuffer.width = width;
+				framebuffer.height = height;
+				if (width > 0 && height > 0) {
+					framebuffer.memory = mem::AllocateMemoryBlock(width * height * sizeof(u32));
+					framebuffer.pixels = mem::PushArray<u32>(&framebuffer.memory, width * height);
+				}
+				tileCountX = (width + SOFTWARE_TILE_SIZE - 1) / SOFTWARE_TILE_SIZE;
+				tileCountY = (height + SOFTWARE_TILE_SIZE - 1) / SOFTWARE_TILE_SIZE;
+			}
+		}
+
+		void *SoftwareRenderer::AllocateTexture(const u32 width, const u32 height, void *data) {
+			SoftwareTexture texture = {};
+			texture.width = width;
+			texture.height = height;
+			texture.pixels.resize(width * height);
+			if (data != nullptr) {
+				memcpy(&texture.pixels[0], data, width * height * sizeof(u32));
+			}
+			textures.emplace_back(texture);
+
+			// Handle is the texture index plus one, so a null handle stays invalid
+			void *result = utils::ValueToPointer(textures.size());
+			return(result);
+		}
+
+		void SoftwareRenderer::BeginFrame() {
+			ResizeFramebuffer(windowSize.w, windowSize.h);
+			primitives.clear();
+		}
+
+		static void RasterizeTiles(const u32 startIndex, const u32 endIndex, void *userData) {
+			SoftwareRenderer *renderer = (SoftwareRenderer *)userData;
+			for (u32 tileIndex = startIndex; tileIndex < endIndex; ++tileIndex) {
+				renderer->RasterizeTile(tileIndex);
+			}
+		}
+
+		void SoftwareRenderer::EndFrame() {
+			BinPrimitives();
+
+			// @NOTE: Tiles never share any pixels and the bins are read-only now, so each tile can be rasterized independently.
+			u32 tileCount = tileCountX * tileCountY;
+			if (workerPool != nullptr) {
+				workerPool->ParallelFor(tileCount, SOFTWARE_TILE_BATCH_SIZE, RasterizeTiles, this);
+			} else {
+				RasterizeTiles(0, tileCount, this);
+			}
+
+			primitives.clear();
+		}
+
+		void SoftwareRenderer::Update(const f32 halfGameWidth, const f32 halfGameHeight, const f32 aspectRatio) {
+			UpdateView(halfGameWidth, halfGameHeight, aspectRatio);
+		}
+
+		Vec2f SoftwareRenderer::Unproject(const Vec2i &windowPos) {
+			Vec2f result = UnprojectView(windowPos);
+			return(result);
+		}
+
+		Vec2f SoftwareRenderer::ProjectToPixel(const Vec2f &worldPos) const {
+			// Same transform as the fixed function pipeline: view projection, then NDC to viewport
+			const f32 *m = &viewProjection.m[0];
+			f32 clipX = m[0] * worldPos.x + m[4] * worldPos.y + m[12];
+			f32 clipY = m[1] * worldPos.x + m[5] * worldPos.y + m[13];
+			Vec2f result;
+			result.x = (f32)viewport.offset.x + (clipX * 0.5f + 0.5f) * (f32)viewport.size.w;
+			result.y = (f32)viewport.offset.y + (clipY * 0.5f + 0.5f) * (f32)viewport.size.h;
+			return(result);
+		}
+
+		bool SoftwareRenderer::ClipBounds(const Vec2f &min, const Vec2f &max, SoftwarePrimitive &primitive) const {
+			// A pixel is covered, when its center is inside
+			s32 minX = (s32)ceilf(min.x - 0.5f);
+			s32 minY = (s32)ceilf(min.y - 0.5f);
+			s32 maxX = (s32)ceilf(max.x - 0.5f);
+			s32 maxY = (s32)ceilf(max.y - 0.5f);
+
+			s32 clipMinX = Maximum(viewport.offset.x, 0);
+			s32 clipMinY = Maximum(viewport.offset.y, 0);
+			s32 clipMaxX = Minimum(viewport.offset.x + viewport.size.w, (s32)framebuffer.width);
+			s32 clipMaxY = Minimum(viewport.offset.y + viewport.size.h, (s32)framebuffer.height);
+
+			primitive.minX = Maximum(minX, clipMinX);
+			primitive.minY = Maximum(minY, clipMinY);
+			primitive.maxX = Minimum(maxX, clipMaxX);
+			primitive.maxY = Minimum(maxY, clipMaxY);
+
+			bool result = (primitive.minX < primitive.maxX) && (primitive.minY < primitive.maxY);
+			return(result);
+		}
+
+		void SoftwareRenderer::PushTriangle(const Vec2f &a, const Vec2f &b, const Vec2f &c, const u32 color) {
+			f32 area = Cross(b - a, c - a);
+			if (area == 0.0f || (color >> 24) == 0) {
+				return;
+			}
+			SoftwarePrimitive primitive = {};
+			primitive.type = SoftwarePrimitiveType::Triangle;
+			primitive.color = color;
+			primitive.v[0] = a;
+			if (area > 0.0f) {
+				primitive.v[1] = b;
+				primitive.v[2] = c;
+			} else {
+				primitive.v[1] = c;
+				primitive.v[2] = b;
+			}
+			Vec2f min = Minimum(a, Minimum(b, c));
+			Vec2f max = Maximum(a, Maximum(b, c));
+			if (ClipBounds(min, max, primitive)) {
+				primitives.emplace_back(primitive);
+			}
+		}
+
+		void SoftwareRenderer::PushLine(const Vec2f &a, const Vec2f &b, const u32 color, const f32 lineWidth) {
+			// Lines are expanded to a quad with the line width in pixels, like glLineWidth()
+			Vec2f d = b - a;
+			f32 len = Length(d);
+			if (len <= 0.0f) {
+				return;
+			}
+			f32 halfWidth = Maximum(lineWidth, 1.0f) * 0.5f;
+			Vec2f n = Vec2f(-d.y, d.x) * (halfWidth / len);
+			PushTriangle(a + n, a - n, b - n, color);
+			PushTriangle(a + n, b - n, b + n, color);
+		}
+
+		void SoftwareRenderer::DrawSprite(const Vec2f &pos, const Vec2f &ext, const Vec4f &color, const Texture &texture, const Vec2f &uvMin, const Vec2f &uvMax) {
+			u32 textureId = utils::PointerToValue<u32>(texture.handle);
+			if (textureId == 0 || textureId > textures.size()) {
+				return;
+			}
+			SoftwarePrimitive primitive = {};
+			primitive.type = SoftwarePrimitiveType::Sprite;
+			primitive.color = PackColor(color);
+			primitive.textureIndex = textureId - 1;
+			primitive.rectMin = ProjectToPixel(pos - ext);
+			primitive.rectMax = ProjectToPixel(pos + ext);
+			primitive.uvMin = uvMin;
+			primitive.uvMax = uvMax;
+			if (ClipBounds(primitive.rectMin, primitive.rectMax, primitive)) {
+				primitives.emplace_back(primitive);
+			}
+		}
+
+		void SoftwareRenderer::DrawRectangle(const Vec2f &pos, const Vec2f &ext, const Vec4f &color, const bool isFilled, const f32 lineWidth) {
+			u32 packedColor = PackColor(color);
+			Vec2f min = ProjectToPixel(pos - ext);
+			Vec2f max = ProjectToPixel(pos + ext);
+			if (isFilled) {
+				SoftwarePrimitive primitive = {};
+				primitive.type = SoftwarePrimitiveType::Rectangle;
+				primitive.color = packedColor;
+				if (ClipBounds(min, max, primitive)) {
+					primitives.emplace_back(primitive);
+				}
+			} else {
+				Vec2f corners[4] = {
+					Vec2f(max.x, max.y),
+					Vec2f(min.x, max.y),
+					Vec2f(min.x, min.y),
+					Vec2f(max.x, min.y),
+				};
+				for (u32 cornerIndex = 0; cornerIndex < 4; ++cornerIndex) {
+					PushLine(corners[cornerIndex], corners[(cornerIndex + 1) % 4], packedColor, lineWidth);
+				}
+			}
+		}
+
+		void SoftwareRenderer::DrawLine(const Vec2f &a, const Vec2f &b, const Vec4f &color, const f32 lineWidth) {
+			PushLine(ProjectToPixel(a), ProjectToPixel(b), PackColor(color), lineWidth);
+		}
+
+		void SoftwareRenderer::DrawCircle(const Vec2f &center, const f32 radius, const Vec4f &color, const bool isFilled, const u32 segmentCount, const f32 lineWidth) {
+			assert(segmentCount >= 3);
+			u32 packedColor = PackColor(color);
+			f32 radForSegment = TAU32 / (f32)segmentCount;
+			Vec2f centerPixel = ProjectToPixel(center);
+			Vec2f lastPoint = ProjectToPixel(center + Vec2f(radius, 0.0f));
+			for (u32 segmentIndex = 1; segmentIndex <= segmentCount; ++segmentIndex) {
+				f32 rad = (f32)segmentIndex * radForSegment;
+				Vec2f point = ProjectToPixel(center + Vec2f(Cosine(rad) * radius, Sine(rad) * radius));
+				if (isFilled) {
+					PushTriangle(centerPixel, lastPoint, point, packedColor);
+				} else {
+					PushLine(lastPoint, point, packedColor, lineWidth);
+				}
+				lastPoint = point;
+			}
+		}
+
+		void SoftwareRenderer::DrawQuads(const RenderVertex *vertices, const u32 vertexCount, const Texture &texture) {
+			assert((vertexCount % 4) == 0);
+			u32 textureId = utils::PointerToValue<u32>(texture.handle);
+			if (textureId == 0 || textureId > textures.size()) {
+				return;
+			}
+			// @NOTE: Quads are expected to be axis aligned, so we rasterize them as sprites.
+			// Vertex 0 is the max corner and vertex 2 the min corner, see DrawSprite()
+			for (u32 vertexIndex = 0; vertexIndex < vertexCount; vertexIndex += 4) {
+				const RenderVertex &maxVertex = vertices[vertexIndex + 0];
+				const RenderVertex &minVertex = vertices[vertexIndex + 2];
+				SoftwarePrimitive primitive = {};
+				primitive.type = SoftwarePrimitiveType::Sprite;
+				primitive.color = PackColor(maxVertex.color);
+				primitive.textureIndex = textureId - 1;
+				primitive.rectMin = ProjectToPixel(minVertex.position);
+				primitive.rectMax = ProjectToPixel(maxVertex.position);
+				primitive.uvMin = minVertex.texcoord;
+				primitive.uvMax = maxVertex.texcoord;
+				if (ClipBounds(primitive.rectMin, primitive.rectMax, primitive)) {
+					primitives.emplace_back(primitive);
+				}
+			}
+		}
+
+		void SoftwareRenderer::BinPrimitives() {
+			// Two passes over all primitives (count, then fill), so each bin keeps the submission order
+			u32 tileCount = tileCountX * tileCountY;
+			tileBins.resize(tileCount);
+			for (u32 tileIndex = 0; tileIndex < tileCount; ++tileIndex) {
+				tileBins[tileIndex] = {};
+			}
+
+			u32 totalCount = 0;
+			for (u32 primitiveIndex = 0; primitiveIndex < primitives.size(); ++primitiveIndex) {
+				const SoftwarePrimitive &primitive = primitives[primitiveIndex];
+				u32 tileMinX = (u32)primitive.minX / SOFTWARE_TILE_SIZE;
+				u32 tileMinY = (u32)primitive.minY / SOFTWARE_TILE_SIZE;
+				u32 tileMaxX = (u32)(primitive.maxX - 1) / SOFTWARE_TILE_SIZE;
+				u32 tileMaxY = (u32)(primitive.maxY - 1) / SOFTWARE_TILE_SIZE;
+				for (u32 tileY = tileMinY; tileY <= tileMaxY; ++tileY) {
+					for (u32 tileX = tileMinX; tileX <= tileMaxX; ++tileX) {
+						++tileBins[tileY * tileCountX + tileX].count;
+						++totalCount;
+					}
+				}
+			}
+
+			u32 offset = 0;
+			for (u32 tileIndex = 0; tileIndex < tileCount; ++tileIndex) {
+				tileBins[tileIndex].firstIndex = offset;
+				offset += tileBins[tileIndex].count;
+				tileBins[tileIndex].count = 0;
+			}
+
+			tilePrimitiveIndices.resize(totalCount);
+			for (u32 primitiveIndex = 0; primitiveIndex < primitives.size(); ++primitiveIndex) {
+				const SoftwarePrimitive &primitive = primitives[primitiveIndex];
+				u32 tileMinX = (u32)primitive.minX / SOFTWARE_TILE_SIZE;
+				u32 tileMinY = (u32)primitive.minY / SOFTWARE_TILE_SIZE;
+				u32 tileMaxX = (u32)(primitive.maxX - 1) / SOFTWARE_TILE_SIZE;
+				u32 tileMaxY = (u32)(primitive.maxY - 1) / SOFTWARE_TILE_SIZE;
+				for (u32 tileY = tileMinY; tileY <= tileMaxY; ++tileY) {
+					for (u32 tileX = tileMinX; tileX <= tileMaxX; ++tileX) {
+						SoftwareTileBin &bin = tileBins[tileY * tileCountX + tileX];
+						tilePrimitiveIndices[bin.firstIndex + bin.count++] = primitiveIndex;
+					}
+				}
+			}
+		}
+
+		void SoftwareRenderer::RasterizeTile(const u32 tileIndex) {
+			s32 tileMinX = (s32)((tileIndex % tileCountX) * SOFTWARE_TILE_SIZE);
+			s32 tileMinY = (s32)((tileIndex / tileCountX) * SOFTWARE_TILE_SIZE);
+			s32 tileMaxX = Minimum(tileMinX + (s32)SOFTWARE_TILE_SIZE, (s32)framebuffer.width);
+			s32 tileMaxY = Minimum(tileMinY + (s32)SOFTWARE_TILE_SIZE, (s32)framebuffer.height);
+			u32 *pixels = framebuffer.pixels;
+			const u32 stride = framebuffer.width;
+
+			// Clear always covers the full framebuffer, same as glClear()
+			for (s32 y = tileMinY; y < tileMaxY; ++y) {
+				StoreSpan(pixels + y * stride + tileMinX, tileMaxX - tileMinX, clearColor);
+			}
+
+			const SoftwareTileBin &bin = tileBins[tileIndex];
+			for (u32 binIndex = 0; binIndex < bin.count; ++binIndex) {
+				const SoftwarePrimitive &primitive = primitives[tilePrimitiveIndices[bin.firstIndex + binIndex]];
+				s32 minX = Maximum(primitive.minX, tileMinX);
+				s32 minY = Maximum(primitive.minY, tileMinY);
+				s32 maxX = Minimum(primitive.maxX, tileMaxX);
+				s32 maxY = Minimum(primitive.maxY, tileMaxY);
+				switch (primitive.type) {
+					case SoftwarePrimitiveType::Rectangle:
+					{
+						for (s32 y = minY; y < maxY; ++y) {
+							FillSpan(pixels + y * stride + minX, maxX - minX, primitive.color);
+						}
+					} break;
+
+					case SoftwarePrimitiveType::Sprite:
+					{
+						// Nearest sampling with clamping, same as GL_NEAREST and GL_CLAMP
+						const SoftwareTexture &texture = textures[primitive.textureIndex];
+						const f32 uScale = (primitive.uvMax.x - primitive.uvMin.x) / (primitive.rectMax.x - primitive.rectMin.x);
+						const f32 vScale = (primitive.uvMax.y - primitive.uvMin.y) / (primitive.rectMax.y - primitive.rectMin.y);
+						for (s32 y = minY; y < maxY; ++y) {
+							f32 v = primitive.uvMin.y + ((f32)y + 0.5f - primitive.rectMin.y) * vScale;
+							s32 texelY = Clamp((s32)floorf(v * (f32)texture.height), 0, (s32)texture.height - 1);
+							const u32 *texelRow = &texture.pixels[texelY * texture.width];
+							u32 *row = pixels + y * stride;
+							for (s32 x = minX; x < maxX; ++x) {
+								f32 u = primitive.uvMin.x + ((f32)x + 0.5f - primitive.rectMin.x) * uScale;
+								s32 texelX = Clamp((s32)floorf(u * (f32)texture.width), 0, (s32)texture.width - 1);
+								u32 texel = ModulatePixel(texelRow[texelX], primitive.color);
+								row[x] = BlendPixel(row[x], texel);
+							}
+						}
+					} break;
+
+					case SoftwarePrimitiveType::Triangle:
+					{
+						SoftwareEdge e0 = MakeEdge(primitive.v[0], primitive.v[1]);
+						SoftwareEdge e1 = MakeEdge(primitive.v[1], primitive.v[2]);
+						SoftwareEdge e2 = MakeEdge(primitive.v[2], primitive.v[0]);
+						for (s32 y = minY; y < maxY; ++y) {
+							// Triangles are convex, so the covered pixels of a row are always one span
+							f32 py = (f32)y + 0.5f;
+							s32 spanMin = minX;
+							while (spanMin < maxX) {
+								f32 px = (f32)spanMin + 0.5f;
+								if (e0.IsInside(px, py) && e1.IsInside(px, py) && e2.IsInside(px, py)) {
+									break;
+								}
+								++spanMin;
+							}
+							s32 spanMax = maxX;
+							while (spanMax > spanMin) {
+								f32 px = (f32)(spanMax - 1) + 0.5f;
+								if (e0.IsInside(px, py) && e1.IsInside(px, py) && e2.IsInside(px, py)) {
+									break;
+								}
+								--spanMax;
+							}
+							if (spanMin < spanMax) {
+								FillSpan(pixels + y * stride + spanMin, spanMax - spanMin, primitive.color);
+							}
+						}
+					} break;
+
+					default:
+						assert(!"Invalid software primitive type!");
+						break;
+				}
+			}
+		}
+	}
+}
@@ -0,0 +1,109 @@
+#pragma once
+
+#include <vector>
+
+#include "final_types.h"
+#include "final_maths.h"
+#include "final_mem.h"
+#include "final_renderer.h"
+#include "final_concurrency.h"
+
+namespace fs {
+	namespace renderer {
+		// Size of one bin in pixels, all primitives are sorted into tiles before they are rasterized
+		constexpr u32 SOFTWARE_TILE_SIZE = 64;
+		// Number of tiles a worker rasterizes in one batch
+		constexpr u32 SOFTWARE_TILE_BATCH_SIZE = 4;
+
+		struct SoftwareTexture {
+			u32 width;
+			u32 height;
+			std::vector<u32> pixels;
+		};
+
+		// @NOTE: Pixels are stored as RGBA8 (same layout as RGBA()), rows are bottom-up like glReadPixels()
+		struct SoftwareFramebuffer {
+			mem::MemoryBlock memory;
+			u32 *pixels;
+			u32 width;
+			u32 height;
+		};
+
+		enum class SoftwarePrimitiveType : u32 {
+			Rectangle = 0,
+			Sprite,
+			Triangle,
+		};
+
+		// Primitive in pixel space, all coordinates are already projected by the view projection
+		struct SoftwarePrimitive {
+			// Pixel bounds clipped to the viewport (max is exclusive)
+			s32 minX;
+			s32 minY;
+			s32 maxX;
+			s32 maxY;
+			SoftwarePrimitiveType type;
+			u32 color;
+			// Triangle vertices in counter clockwise order
+			Vec2f v[3];
+			// Sprite rectangle and texture coordinates
+			Vec2f rectMin;
+			Vec2f rectMax;
+			Vec2f uvMin;
+			Vec2f uvMax;
+			u32 textureIndex;
+		};
+
+		struct SoftwareTileBin {
+			u32 firstIndex;
+			u32 count;
+		};
+
+		// Renderer which rasterizes everything into a CPU framebuffer, no GPU or window required.
+		// Primitives are collected during the frame and rasterized tile by tile in EndFrame(), in parallel when a worker pool is set.
+		class SoftwareRenderer : public Renderer {
+		private:
+			SoftwareFramebuffer framebuffer;
+			std::vector<SoftwareTexture> textures;
+			std::vector<SoftwarePrimitive> primitives;
+			std::vector<SoftwareTileBin> tileBins;
+			std::vector<u32> tilePrimitiveIndices;
+			u32 tileCountX;
+			u32 tileCountY;
+			concurrency::WorkerPool *workerPool;
+
+			void ResizeFramebuffer(const u32 width, const u32 height);
+			Vec2f ProjectToPixel(const Vec2f &worldPos) const;
+			bool ClipBounds(const Vec2f &min, const Vec2f &max, SoftwarePrimitive &primitive) const;
+			void PushTriangle(const Vec2f &a, const Vec2f &b, const Vec2f &c, const u32 color);
+			void PushLine(const Vec2f &a, const Vec2f &b, const u32 color, const f32 lineWidth);
+			void BinPrimitives();
+		public:
+			// Clear color, opaque black by default
+			u32 clearColor;
+
+			void *AllocateTexture(const u32 width, const u32 height, void *data) override;
+			void BeginFrame() override;
+			void EndFrame() override;
+			void Update(const f32 halfGameWidth, const f32 halfGameHeight, const f32 aspectRatio) override;
+			Vec2f Unproject(const Vec2i &windowPos) override;
+			void DrawSprite(const Vec2f &pos, const Vec2f &ext, const Vec4f &color, const Texture &texture, const Vec2f &uvMin, const Vec2f &uvMax) override;
+			void DrawRectangle(const Vec2f &pos, const Vec2f &ext, const Vec4f &color, const bool isFilled, const f32 lineWidth) override;
+			void DrawLine(const Vec2f &a, const Vec2f &b, const Vec4f &color, const f32 lineWidth) override;
+			void DrawCircle(const Vec2f &center, const f32 radius, const Vec4f &color, const bool isFilled, const u32 segmentCount, const f32 lineWidth) override;
+			void DrawQuads(const RenderVertex *vertices, const u32 vertexCount, const Texture &texture) override;
+
+			void RasterizeTile(const u32 tileIndex);
+
+			inline const SoftwareFramebuffer &GetFramebuffer() const {
+				return framebuffer;
+			}
+			inline void SetWorkerPool(concurrency::WorkerPool *workerPool) {
+				this->workerPool = workerPool;
+			}
+
+			SoftwareRenderer(const u32 width, const u32 height);
+			~SoftwareRenderer();
+		};
+	};
+};
@@ -1,10 +1,15 @@
 #include "final_tiletrace.h"
 
+#include <algorithm>
+
 #include "final_utils.h"
+#include "final_randoms.h"
+#include "final_concurrency.h"
 
-using namespace finalspace::utils;
+using namespace fpl;
+using namespace fs::utils;
 
-namespace finalspace {
+namespace fs {
 	namespace tiletracer {
 		/*
 		https://en.wikipedia.org/wiki/Moore_neighborhood
@@ -110,13 +115,13 @@ namespace finalspace {
 			}
 		}
 
-		static TileTraceTile *GetFirstSolidTile(std::vector<TileTraceTile> &tiles, const Vec2u &dimension) {
-			for (u32 tileY = 0; tileY < dimension.h; ++tileY) {
-				for (u32 tileX = 0; tileX < dimension.w; ++tileX) {
-					if (IsTileSolid(tiles, dimension, tileX, tileY)) {
-						TileTraceTile *tile = GetTile(tiles, dimension, tileX, tileY);
-						return tile;
-					}
+		// @NOTE: Tiles are only removed and never added, so the raster scan can continue where the last one has stopped
+		static TileTraceTile *GetFirstSolidTile(std::vector<TileTraceTile> &tiles, const Vec2u &dimension, u32 &scanTileIndex) {
+			u32 tileCount = dimension.w * dimension.h;
+			for (; scanTileIndex < tileCount; ++scanTileIndex) {
+				TileTraceTile *tile = &tiles[scanTileIndex];
+				if (tile->isSolid > 0) {
+					return tile;
 				}
 			}
 			return nullptr;
@@ -131,25 +136,127 @@ namespace finalspace {
 			return(result);
 		}
 
+		// Minimum number of entries in a hash table, must be a power of two
+		constexpr u32 TILETRACE_MIN_HASH_CAPACITY = 1024;
+
+		// Special hash entry values
+		constexpr s32 TILETRACE_HASH_EMPTY = -1;
+		constexpr s32 TILETRACE_HASH_REMOVED = -2;
+
+		inline u64 ComputeEdgeHash(s32 vertIndex0, s32 vertIndex1) {
+			u64 result = ((u64)(u32)vertIndex0 << 32) | (u64)(u32)vertIndex1;
+			return(result);
+		}
+
+		inline u32 GetHashSlot(const TileHashTable &table, const u64 key) {
+			// @NOTE: Fibonacci hashing, so neighbouring coordinates are spread across the table
+			u64 hash = key * 11400714819323198485ULL;
+			u32 result = (u32)(hash >> 32) & (table.capacity - 1);
+			return(result);
+		}
+
+		static void InitHashTable(TileHashTable &table, const u32 capacity) {
+			assert((capacity & (capacity - 1)) == 0);
+			table.memory = mem::AllocateMemoryBlock(sizeof(TileHashEntry) * capacity);
+			table.entries = mem::PushArray<TileHashEntry>(&table.memory, capacity, false);
+			for (u32 entryIndex = 0; entryIndex < capacity; ++entryIndex) {
+				table.entries[entryIndex].value = TILETRACE_HASH_EMPTY;
+			}
+			table.capacity = capacity;
+			table.count = 0;
+			table.usedCount = 0;
+		}
+
+		static void ReleaseHashTable(TileHashTable &table) {
+			mem::ReleaseMemoryBlock(&table.memory);
+			table = {};
+		}
+
+		static s32 HashFind(const TileHashTable &table, const u64 key) {
+			u32 slot = GetHashSlot(table, key);
+			while (table.entries[slot].value != TILETRACE_HASH_EMPTY) {
+				if (table.entries[slot].value != TILETRACE_HASH_REMOVED && table.entries[slot].key == key) {
+					return table.entries[slot].value;
+				}
+				slot = (slot + 1) & (table.capacity - 1);
+			}
+			return TILETRACE_HASH_EMPTY;
+		}
+
+		static void HashInsert(TileHashTable &table, const u64 key, const s32 value);
+
+		static void RehashTable(TileHashTable &table) {
+			// Removed entries are dropped, the capacity only grows when the live entries needs it
+			u32 capacity = table.capacity;
+			if ((u64)(table.count + 1) * 10 > (u64)capacity * 5) {
+				capacity *= 2;
+			}
+			TileHashTable oldTable = table;
+			InitHashTable(table, capacity);
+			for (u32 entryIndex = 0; entryIndex < oldTable.capacity; ++entryIndex) {
+				const TileHashEntry &entry = oldTable.entries[entryIndex];
+				if (entry.value >= 0) {
+					HashInsert(table, entry.key, entry.value);
+				}
+			}
+			ReleaseHashTable(oldTable);
+		}
+
+		// @NOTE: Key must not be in the table already
+		static void HashInsert(TileHashTable &table, const u64 key, const s32 value) {
+			assert(value >= 0);
+			// Keep the load factor below 70%, so the probe sequences stays short
+			if ((u64)(table.usedCount + 1) * 10 > (u64)table.capacity * 7) {
+				RehashTable(table);
+			}
+			u32 slot = GetHashSlot(table, key);
+			while (table.entries[slot].value >= 0) {
+				slot = (slot + 1) & (table.capacity - 1);
+			}
+			if (table.entries[slot].value == TILETRACE_HASH_EMPTY) {
+				++table.usedCount;
+			}
+			table.entries[slot].key = key;
+			table.entries[slot].value = value;
+			++table.count;
+		}
+
+		static bool HashRemove(TileHashTable &table, const u64 key) {
+			u32 slot = GetHashSlot(table, key);
+			while (table.entries[slot].value != TILETRACE_HASH_EMPTY) {
+				if (table.entries[slot].value != TILETRACE_HASH_REMOVED && table.entries[slot].key == key) {
+					table.entries[slot].value = TILETRACE_HASH_REMOVED;
+					--table.count;
+					return true;
+				}
+				slot = (slot + 1) & (table.capacity - 1);
+			}
+			return false;
+		}
+
+		static s32 FindVertex(TileTracer &tracer, const Vec2i &vertex) {
+			u64 key = ComputeTileHash((u32)vertex.x, (u32)vertex.y);
+			s32 result = HashFind(tracer.vertexHash, key);
+			return(result);
+		}
+
+		static s32 FindOrAddVertex(TileTracer &tracer, const Vec2i &vertex) {
+			u64 key = ComputeTileHash((u32)vertex.x, (u32)vertex.y);
+			s32 result = HashFind(tracer.vertexHash, key);
+			if (result == TILETRACE_HASH_EMPTY) {
+				result = (s32)tracer.mainVertices.size();
+				tracer.mainVertices.push_back(vertex);
+				HashInsert(tracer.vertexHash, key, result);
+			}
+			return(result);
+		}
+
 		static TileIndices PushTileVertices(TileTracer &tracer, TileTraceTile *tile) {
 			TileIndices result = {};
 			TileVertices tileVerts = CreateTileVertices(tile);
 			assert(ArrayCount(tileVerts.verts) == ArrayCount(result.indices));
 			for (u32 vertIndex = 0; vertIndex < ArrayCount(tileVerts.verts); ++vertIndex) {
-				Vec2i vertex = tileVerts.verts[vertIndex];
-				s32 matchedMainVertexIndex = -1;
-				for (u32 mainVertexIndex = 0; mainVertexIndex < tracer.mainVertices.size(); ++mainVertexIndex) {
-					if (IsEqual(tracer.mainVertices[mainVertexIndex], vertex)) {
-						matchedMainVertexIndex = mainVertexIndex;
-						break;
-					}
-				}
-				if (matchedMainVertexIndex == -1) {
-					result.indices[vertIndex] = (s32)tracer.mainVertices.size();
-					tracer.mainVertices.push_back(vertex);
-				} else {
-					result.indices[vertIndex] = matchedMainVertexIndex;
-				}
+				result.indices[vertIndex] = FindOrAddVertex(tracer, tileVerts.verts[vertIndex]);
 			}
 			return(result);
 		}
@@ -169,16 +276,14 @@ namespace finalspace {
 			TileEdges result = {};
 			for (u32 edgeIndex = 0; edgeIndex < inputEdges.count; ++edgeIndex) {
 				TileTraceEdge inputEdge = inputEdges.edges[edgeIndex];
-				bool addIt = true;
-				for (u32 mainEdgeIndex = 0; mainEdgeIndex < tracer.mainEdges.size(); ++mainEdgeIndex) {
-					TileTraceEdge mainEdge = tracer.mainEdges[mainEdgeIndex];
-					if (inputEdge.vertIndex0 == mainEdge.vertIndex1 && inputEdge.vertIndex1 == mainEdge.vertIndex0) {
-						addIt = false;
-						tracer.mainEdges.erase(tracer.mainEdges.begin() + mainEdgeIndex);
-						break;
-					}
-				}
-				if (addIt) {
+				// A overlapping edge is the same edge in the opposite direction
+				u64 overlapKey = ComputeEdgeHash(inputEdge.vertIndex1, inputEdge.vertIndex0);
+				s32 mainEdgeIndex = HashFind(tracer.edgeHash, overlapKey);
+				if (mainEdgeIndex != TILETRACE_HASH_EMPTY) {
+					// @NOTE: Cancelled edges stays in the main edges as invalid until the traversal starts, so we never shift the list
+					HashRemove(tracer.edgeHash, overlapKey);
+					tracer.mainEdges[mainEdgeIndex].isInvalid = true;
+				} else {
 					result.edges[result.count++] = inputEdge;
 				}
 			}
@@ -187,14 +292,16 @@ namespace finalspace {
 
 		static bool IsTileSharedCommonEdges(TileTracer &tracer, TileVertices tileVertices) {
 			u64 vertexCount = ArrayCount(tileVertices.verts);
+			s32 vertIndices[4];
+			assert(ArrayCount(vertIndices) == vertexCount);
 			for (u32 vertIndex = 0; vertIndex < vertexCount; ++vertIndex) {
-				Vec2i tv0 = tileVertices.verts[vertIndex];
-				Vec2i tv1 = tileVertices.verts[(vertIndex + 1) % vertexCount];
-				for (u32 edgeIndex = 0; edgeIndex < tracer.mainEdges.size(); ++edgeIndex) {
-					TileTraceEdge edge = tracer.mainEdges[edgeIndex];
-					Vec2i mv0 = tracer.mainVertices[edge.vertIndex0];
-					Vec2i mv1 = tracer.mainVertices[edge.vertIndex1];
-					if (IsEqual(tv0, mv1) && IsEqual(tv1, mv0)) {
+				vertIndices[vertIndex] = FindVertex(tracer, tileVertices.verts[vertIndex]);
+			}
+			for (u32 vertIndex = 0; vertIndex < vertexCount; ++vertIndex) {
+				s32 v0 = vertIndices[vertIndex];
+				s32 v1 = vertIndices[(vertIndex + 1) % vertexCount];
+				if (v0 != TILETRACE_HASH_EMPTY && v1 != TILETRACE_HASH_EMPTY) {
+					if (HashFind(tracer.edgeHash, ComputeEdgeHash(v1, v0)) != TILETRACE_HASH_EMPTY) {
 						return true;
 					}
 				}
@@ -202,64 +309,116 @@ namespace finalspace {
 			return false;
 		}
 
-		inline void RemoveSegmentVertex(TileTraceChainSegment *chainSegment, u32 index) {
-			utils::ArrayRemoveAndKeepOrder<Vec2i, u32>(chainSegment->vertices, index, chainSegment->vertexCount);
+		static void BuildEdgeTraversal(TileTracer &tracer) {
+			// Drop all cancelled edges, but keep the order of the others
+			u32 edgeCount = 0;
+			for (u32 mainEdgeIndex = 0; mainEdgeIndex < tracer.mainEdges.size(); ++mainEdgeIndex) {
+				if (!tracer.mainEdges[mainEdgeIndex].isInvalid) {
+					tracer.mainEdges[edgeCount++] = tracer.mainEdges[mainEdgeIndex];
+				}
+			}
+			tracer.mainEdges.resize(edgeCount);
+
+			// Outgoing edges for each vertex in the same order as the main edges, so the traversal picks the same edges as a full scan
+			u32 vertexCount = (u32)tracer.mainVertices.size();
+			tracer.vertexEdgeOffsets.assign(vertexCount + 1, 0);
+			tracer.vertexEdges.resize(edgeCount);
+			for (u32 mainEdgeIndex = 0; mainEdgeIndex < edgeCount; ++mainEdgeIndex) {
+				++tracer.vertexEdgeOffsets[tracer.mainEdges[mainEdgeIndex].vertIndex0 + 1];
+			}
+			for (u32 vertIndex = 0; vertIndex < vertexCount; ++vertIndex) {
+				tracer.vertexEdgeOffsets[vertIndex + 1] += tracer.vertexEdgeOffsets[vertIndex];
+			}
+			std::vector<u32> insertOffsets = std::vector<u32>(tracer.vertexEdgeOffsets.begin(), tracer.vertexEdgeOffsets.end() - 1);
+			for (u32 mainEdgeIndex = 0; mainEdgeIndex < edgeCount; ++mainEdgeIndex) {
+				s32 vertIndex0 = tracer.mainEdges[mainEdgeIndex].vertIndex0;
+				tracer.vertexEdges[insertOffsets[vertIndex0]++] = mainEdgeIndex;
+			}
+			tracer.nextStartEdgeIndex = 0;
+		}
+
+		inline Vec2i &GetSegmentVertex(TileTracer &tracer, TileTraceChainSegment *segment, u32 index) {
+			assert(index < segment->vertexCount);
+			return tracer.chainVertices[segment->firstVertex + index];
+		}
+
+		// @NOTE: Vertices are only removed at the start or the end of the current segment, so nothing needs to be shifted
+		inline void RemoveSegmentVertex(TileTracer &tracer, TileTraceChainSegment *segment, u32 index) {
+			assert(segment->vertexCount > 0);
+			assert(segment->firstVertex + segment->vertexCount == tracer.chainVertices.size());
+			if (index == 0) {
+				++segment->firstVertex;
+			} else {
+				assert(index >= segment->vertexCount - 2);
+				if (index == segment->vertexCount - 2) {
+					GetSegmentVertex(tracer, segment, index) = GetSegmentVertex(tracer, segment, index + 1);
+				}
+				tracer.chainVertices.pop_back();
+			}
+			--segment->vertexCount;
 		}
 
-		static void ClearLineSegmentPoints(TileTraceChainSegment *segment, u32 firstIndex, u32 middleIndex, u32 lastIndex) {
-			Vec2i last = segment->vertices[lastIndex];
-			Vec2i middle = segment->vertices[middleIndex];
-			Vec2i first = segment->vertices[firstIndex];
+		static void ClearLineSegmentPoints(TileTracer &tracer, TileTraceChainSegment *segment, u32 firstIndex, u32 middleIndex, u32 lastIndex) {
+			Vec2i last = GetSegmentVertex(tracer, segment, lastIndex);
+			Vec2i middle = GetSegmentVertex(tracer, segment, middleIndex);
+			Vec2i first = GetSegmentVertex(tracer, segment, firstIndex);
 			Vec2i d1 = last - middle;
 			Vec2i d2 = middle - first;
 			s32 d = Dot(d1, d2);
 			if (d > 0) {
-				RemoveSegmentVertex(segment, middleIndex);
+				RemoveSegmentVertex(tracer, segment, middleIndex);
 			}
 		}
 
-		static void OptimizeChainSegment(TileTraceChainSegment *segment) {
+		// Removes the previous vertex when it lies on the line to the vertex just added
+		static void OptimizeChainSegment(TileTracer &tracer, TileTraceChainSegment *segment) {
 			if (segment->vertexCount > 2) {
 				u32 lastIndex = segment->vertexCount - 1;
-				ClearLineSegmentPoints(segment, lastIndex - 2, lastIndex - 1, lastIndex);
+				ClearLineSegmentPoints(tracer, segment, lastIndex - 2, lastIndex - 1, lastIndex);
 			}
 		}
 
-		static void FinalizeChainSegment(TileTraceChainSegment *chainSegment) {
+		static void FinalizeChainSegment(TileTracer &tracer, TileTraceChainSegment *chainSegment) {
 			if (chainSegment->vertexCount > 2) {
-				ClearLineSegmentPoints(chainSegment, chainSegment->vertexCount - 1, 0, 1);
+				ClearLineSegmentPoints(tracer, chainSegment, chainSegment->vertexCount - 1, 0, 1);
 			}
 			if (chainSegment->vertexCount > 2) {
-				ClearLineSegmentPoints(chainSegment, 0, chainSegment->vertexCount - 1, chainSegment->vertexCount - 2);
+				ClearLineSegmentPoints(tracer, chainSegment, 0, chainSegment->vertexCount - 1, chainSegment->vertexCount - 2);
 			}
 		}
 
-		inline void AddChainSegmentVertex(TileTraceChainSegment *chainSegment, const Vec2i &vertex) {
-			assert(chainSegment->vertexCount < ArrayCount(chainSegment->vertices));
-			chainSegment->vertices[chainSegment->vertexCount++] = vertex;
+		inline void AddChainSegmentVertex(TileTracer &tracer, TileTraceChainSegment *chainSegment, const Vec2i &vertex) {
+			assert(chainSegment->firstVertex + chainSegment->vertexCount == tracer.chainVertices.size());
+			tracer.chainVertices.push_back(vertex);
+			++chainSegment->vertexCount;
 		}
 
 		static bool ProcessTraverseNextEdge(TileTracer &tracer) {
-			for (u32 mainEdgeIndex = 0; mainEdgeIndex < tracer.mainEdges.size(); ++mainEdgeIndex) {
-				TileTraceEdge *curEdge = &tracer.mainEdges[mainEdgeIndex];
-				if (!curEdge->isInvalid && (curEdge->vertIndex0 == tracer.lastEdge->vertIndex1)) {
+			// Only the outgoing edges from the end of the last edge can continue the chain
+			s32 lastVertIndex = tracer.lastEdge->vertIndex1;
+			u32 firstOutgoingIndex = tracer.vertexEdgeOffsets[lastVertIndex];
+			u32 lastOutgoingIndex = tracer.vertexEdgeOffsets[lastVertIndex + 1];
+			for (u32 outgoingIndex = firstOutgoingIndex; outgoingIndex < lastOutgoingIndex; ++outgoingIndex) {
+				TileTraceEdge *curEdge = &tracer.mainEdges[tracer.vertexEdges[outgoingIndex]];
+				if (!curEdge->isInvalid) {
 					// If v0 from current edge equals starting edge - then we are finished
 					if (curEdge->vertIndex1 == tracer.startEdge->vertIndex0) {
 						// We are done with this line segment - Set cur step to find next starting edge
 						tracer.lastEdge = nullptr;
 						tracer.curStep = TileTraceStep::TraverseFindStartingEdge;
 						// Optimize and finalize shape
-						OptimizeChainSegment(tracer.curChainSegment);
-						FinalizeChainSegment(tracer.curChainSegment);
+						OptimizeChainSegment(tracer, tracer.curChainSegment);
+						FinalizeChainSegment(tracer, tracer.curChainSegment);
 						// Add list vertex to the end again, because we have a fully closed chain
-						AddChainSegmentVertex(tracer.curChainSegment, tracer.curChainSegment->vertices[0]);
+						Vec2i firstVertex = GetSegmentVertex(tracer, tracer.curChainSegment, 0);
+						AddChainSegmentVertex(tracer, tracer.curChainSegment, firstVertex);
 					} else {
 						// Now our current edge is the last edge
 						tracer.lastEdge = curEdge;
 						// Add always the first edge vertex to the list
-						AddChainSegmentVertex(tracer.curChainSegment, tracer.mainVertices[curEdge->vertIndex1]);
+						AddChainSegmentVertex(tracer, tracer.curChainSegment, tracer.mainVertices[curEdge->vertIndex1]);
 						// Optimize shape
-						OptimizeChainSegment(tracer.curChainSegment);
+						OptimizeChainSegment(tracer, tracer.curChainSegment);
 					}
 					curEdge->isInvalid = true;
 					return true;
@@ -272,8 +431,8 @@ namespace finalspace {
 				tracer.lastEdge = nullptr;
 				tracer.curStep = TileTraceStep::TraverseFindStartingEdge;
 				// Optimize and finalize shape
-				OptimizeChainSegment(tracer.curChainSegment);
-				FinalizeChainSegment(tracer.curChainSegment);
+				OptimizeChainSegment(tracer, tracer.curChainSegment);
+				FinalizeChainSegment(tracer, tracer.curChainSegment);
 				return true;
 			}
 
@@ -287,12 +446,13 @@ namespace finalspace {
 			bool result = false;
 
 			// Find next free starting edge - at the start this is always null
+			// Edges never gets valid again, so the search continues where the last one has stopped
 			tracer.startEdge = nullptr;
 			s32 startEdgeIndex = -1;
-			for (u32 mainEdgeIndex = 0; mainEdgeIndex < tracer.mainEdges.size(); ++mainEdgeIndex) {
-				TileTraceEdge *mainEdge = &tracer.mainEdges[mainEdgeIndex];
+			for (; tracer.nextStartEdgeIndex < tracer.mainEdges.size(); ++tracer.nextStartEdgeIndex) {
+				TileTraceEdge *mainEdge = &tracer.mainEdges[tracer.nextStartEdgeIndex];
 				if (!mainEdge->isInvalid) {
-					startEdgeIndex = mainEdgeIndex;
+					startEdgeIndex = tracer.nextStartEdgeIndex;
 					tracer.startEdge = mainEdge;
 					break;
 				}
@@ -304,10 +464,12 @@ namespace finalspace {
 				tracer.lastEdge = tracer.startEdge;
 				tracer.mainEdges[startEdgeIndex].isInvalid = true;
 				tracer.curStep = TileTraceStep::TraverseNextEdge;
-				tracer.chainSegments.push_back({});
+				TileTraceChainSegment newChainSegment = {};
+				newChainSegment.firstVertex = (u32)tracer.chainVertices.size();
+				tracer.chainSegments.push_back(newChainSegment);
 				tracer.curChainSegment = &tracer.chainSegments[tracer.chainSegments.size() - 1];
-				AddChainSegmentVertex(tracer.curChainSegment, tracer.mainVertices[tracer.startEdge->vertIndex0]);
-				AddChainSegmentVertex(tracer.curChainSegment, tracer.mainVertices[tracer.startEdge->vertIndex1]);
+				AddChainSegmentVertex(tracer, tracer.curChainSegment, tracer.mainVertices[tracer.startEdge->vertIndex0]);
+				AddChainSegmentVertex(tracer, tracer.curChainSegment, tracer.mainVertices[tracer.startEdge->vertIndex1]);
 			} else {
 				// We are completely done
 				tracer.curStep = TileTraceStep::Done;
@@ -318,27 +480,55 @@ namespace finalspace {
 
 		void TileTracer::Init(const Vec2u &tileCount, u8 *mapTiles) {
 			this->tileCount = tileCount;
-			tiles.reserve(tileCount.x  * tileCount.y);
+			tiles.resize(tileCount.x  * tileCount.y);
+			u32 solidTileCount = 0;
 			for (u32 tileY = 0; tileY < tileCount.h; ++tileY) {
 				for (u32 tileX = 0; tileX < tileCount.w; ++tileX) {
 					u32 tileIndex = ComputeTileIndex(tileCount, tileX, tileY);
 					b32 isSolid = mapTiles[tileIndex] > 0;
 					TileTraceTile *tile = &tiles[tileIndex];
 					*tile = MakeTile(tileX, tileY, isSolid);
+					if (isSolid) {
+						++solidTileCount;
+					}
 				}
 			}
 
+			// Most vertices and edges are shared between tiles, so start with roughly two entries per solid tile and grow when needed
+			u32 hashCapacity = TILETRACE_MIN_HASH_CAPACITY;
+			while (hashCapacity < solidTileCount * 2) {
+				hashCapacity *= 2;
+			}
+			ReleaseHashTable(vertexHash);
+			ReleaseHashTable(edgeHash);
+			InitHashTable(vertexHash, hashCapacity);
+			InitHashTable(edgeHash, hashCapacity);
+			vertexEdgeOffsets.clear();
+			vertexEdges.clear();
+			nextStartEdgeIndex = 0;
+
 			curStep = TileTraceStep::FindStart;
 			openList.clear();
+			scanTileIndex = 0;
 			startTile = nullptr;
 			mainVertices.clear();
 			mainEdges.clear();
 			chainSegments.clear();
+			chainVertices.clear();
+			chainSortKeys.clear();
+			chainGroupKeys.clear();
+			tileGroupKeys.clear();
+			dirtyTiles.clear();
 
 			curTile = nullptr;
 			nextTile = nullptr;
 		}
 
+		void TileTracer::Release() {
+			ReleaseHashTable(vertexHash);
+			ReleaseHashTable(edgeHash);
+		}
+
 		static void GetNextOpenTile(TileTracer &tracer) {
 			if (tracer.openList.size() > 0) {
 				tracer.curTile = tracer.openList[tracer.openList.size() - 1];
@@ -359,10 +549,11 @@ namespace finalspace {
 			}
 		}
 
-		static void AddTile(TileTracer &tracer, TileTraceTile *tile) {
+		// @NOTE: The tiles are passed separately, so a tracer can work on the tiles of another tracer (see RunParallel)
+		static void AddTile(TileTracer &tracer, std::vector<TileTraceTile> &tiles, TileTraceTile *tile) {
 			// Add the start tile to the open list and remove it from the map
 			tracer.openList.push_back(tile);
-			RemoveTile(tracer.tiles, tracer.tileCount, tile->x, tile->y);
+			RemoveTile(tiles, tracer.tileCount, tile->x, tile->y);
 
 			// Create tile vertices/indices and edges for the next tile
 			TileIndices tileIndices = PushTileVertices(tracer, tile);
@@ -373,7 +564,9 @@ namespace finalspace {
 
 			// Push the remaining edges to the main edges list
 			for (u32 tileEdgeIndex = 0; tileEdgeIndex < tileEdges.count; ++tileEdgeIndex) {
-				tracer.mainEdges.push_back(tileEdges.edges[tileEdgeIndex]);
+				const TileTraceEdge &tileEdge = tileEdges.edges[tileEdgeIndex];
+				HashInsert(tracer.edgeHash, ComputeEdgeHash(tileEdge.vertIndex0, tileEdge.vertIndex1), (s32)tracer.mainEdges.size());
+				tracer.mainEdges.push_back(tileEdge);
 			}
 		}
 
@@ -396,10 +589,10 @@ namespace finalspace {
 				{
 					openList.clear();
 					curTile = nullptr;
-					startTile = GetFirstSolidTile(tiles, tileCount);
+					startTile = GetFirstSolidTile(tiles, tileCount, scanTileIndex);
 					if (startTile != nullptr) {
 						// Add the start tile to the open list and build vertices and edges from it
-						AddTile(*this, startTile);
+						AddTile(*this, tiles, startTile);
 
 						// Set next step to get open tile and process it immediatitly
 						curStep = TileTraceStep::GetNextOpenTile;
@@ -411,6 +604,8 @@ namespace finalspace {
 						} else {
 							// Clear all chain segments
 							chainSegments.clear();
+							chainVertices.clear();
+							BuildEdgeTraversal(*this);
 							curStep = TileTraceStep::TraverseFindStartingEdge;
 						}
 					}
@@ -434,7 +629,7 @@ namespace finalspace {
 						bool sharesCommonEdge = IsTileSharedCommonEdges(*this, tileVertices);
 						if (sharesCommonEdge) {
 							// Add the next tile to the open list and build vertices and edges from it
-							AddTile(*this, nextTile);
+							AddTile(*this, tiles, nextTile);
 
 							// Set next step to get open tile and process it immediatitly
 							curStep = TileTraceStep::GetNextOpenTile;
@@ -458,5 +653,564 @@ namespace finalspace {
 			}
 			return(result);
 		}
+
+		// Adds all tiles connected to the tiles in the open list
+		static void FloodFillTiles(TileTracer &tracer, std::vector<TileTraceTile> &tiles) {
+			// @NOTE: Same visiting order as the FindNextTile/RotateForward steps, so we get the exact same edges.
+			// The shared edge test is skipped, a solid neighbour of a added tile always shares the edge between them.
+			while (tracer.openList.size() > 0) {
+				TileTraceTile *curTile = tracer.openList[tracer.openList.size() - 1];
+				s32 nx = curTile->x + TILETRACE_DIRECTIONS[curTile->traceDirection].x;
+				s32 ny = curTile->y + TILETRACE_DIRECTIONS[curTile->traceDirection].y;
+				if (IsTileSolid(tiles, tracer.tileCount, nx, ny)) {
+					AddTile(tracer, tiles, GetTile(tiles, tracer.tileCount, nx, ny));
+				} else if (curTile->traceDirection < (TILETRACE_DIRECTION_COUNT - 1)) {
+					++curTile->traceDirection;
+				} else {
+					tracer.openList.pop_back();
+				}
+			}
+		}
+
+		void TileTracer::Run() {
+			assert(curStep == TileTraceStep::FindStart);
+
+			// Flood fill every connected group of solid tiles, starting from the first solid tile in raster order
+			for (;;) {
+				startTile = GetFirstSolidTile(tiles, tileCount, scanTileIndex);
+				if (startTile == nullptr) {
+					break;
+				}
+				AddTile(*this, tiles, startTile);
+				FloodFillTiles(*this, tiles);
+			}
+			curTile = nullptr;
+			nextTile = nullptr;
+
+			// Extract all contours from the remaining edges
+			chainSegments.clear();
+			chainVertices.clear();
+			if (mainEdges.size() > 0) {
+				BuildEdgeTraversal(*this);
+				curStep = TileTraceStep::TraverseFindStartingEdge;
+				while (ProcessTraverseFindStartingEdge(*this)) {
+					while (curStep == TileTraceStep::TraverseNextEdge) {
+						ProcessTraverseNextEdge(*this);
+					}
+				}
+			}
+			curStep = TileTraceStep::Done;
+		}
+
+		//
+		// Parallel tracing
+		//
+		// Tiles connected by a edge form a component, which is what the flood fill visits.
+		// Components touching each other by a corner share a vertex, so the traversal can walk from one into the other.
+		// Therefore all components touching each other are put into one group, and each group is traced on its own.
+		//
+		constexpr u32 TILETRACE_NO_COMPONENT = UINT32_MAX;
+
+		struct TileTraceGroup {
+			u32 firstComponent;
+			u32 componentCount;
+			u32 tileCount;
+			// First tile index in raster order of the group
+			u32 key;
+		};
+
+		struct TileTraceBatchResult {
+			std::vector<TileTraceChainSegment> chainSegments;
+			std::vector<Vec2i> chainVertices;
+			// Start tile index of the component owning the start edge, for each chain segment
+			std::vector<u32> chainSortKeys;
+			// Key of the group the chain segment belongs to
+			std::vector<u32> chainGroupKeys;
+		};
+
+		struct TileTraceParallelContext {
+			TileTracer *tracer;
+			// Tiles to label in raster order, all tiles when empty
+			std::vector<u32> regionTiles;
+			// Component for each tile
+			std::vector<u32> tileComponents;
+			// First tile index in raster order for each component
+			std::vector<u32> componentStartTiles;
+			// Group for each component
+			std::vector<u32> componentGroups;
+			// Components sorted by group, see TileTraceGroup
+			std::vector<u32> groupComponents;
+			std::vector<TileTraceGroup> groups;
+			std::vector<TileTraceBatchResult> batchResults;
+			u32 batchSize;
+		};
+
+		static u32 FindComponentRoot(std::vector<u32> &parents, u32 component) {
+			while (parents[component] != component) {
+				parents[component] = parents[parents[component]];
+				component = parents[component];
+			}
+			return(component);
+		}
+
+		static void LabelTileGroups(TileTraceParallelContext &context) {
+			TileTracer &tracer = *context.tracer;
+			const Vec2u &tileCount = tracer.tileCount;
+			u32 totalTileCount = tileCount.w * tileCount.h;
+			bool isRegion = context.regionTiles.size() > 0;
+			u32 candidateCount = isRegion ? (u32)context.regionTiles.size() : totalTileCount;
+
+			// Label the components in raster order, so the component index order is the same order Run() finds them
+			// @NOTE: A region must contain every solid tile touching it, so the flood fill never leaves it
+			context.tileComponents.assign(totalTileCount, TILETRACE_NO_COMPONENT);
+			context.componentStartTiles.clear();
+			std::vector<u32> componentTileCounts;
+			std::vector<u32> fillStack;
+			for (u32 candidateIndex = 0; candidateIndex < candidateCount; ++candidateIndex) {
+				u32 tileIndex = isRegion ? context.regionTiles[candidateIndex] : candidateIndex;
+				if (tracer.tiles[tileIndex].isSolid > 0 && context.tileComponents[tileIndex] == TILETRACE_NO_COMPONENT) {
+					u32 component = (u32)context.componentStartTiles.size();
+					context.componentStartTiles.push_back(tileIndex);
+					u32 componentTileCount = 0;
+					context.tileComponents[tileIndex] = component;
+					fillStack.push_back(tileIndex);
+					while (fillStack.size() > 0) {
+						u32 fillIndex = fillStack[fillStack.size() - 1];
+						fillStack.pop_back();
+						++componentTileCount;
+						const TileTraceTile &fillTile = tracer.tiles[fillIndex];
+						for (u32 directionIndex = 0; directionIndex < TILETRACE_DIRECTION_COUNT; ++directionIndex) {
+							s32 nx = fillTile.x + TILETRACE_DIRECTIONS[directionIndex].x;
+							s32 ny = fillTile.y + TILETRACE_DIRECTIONS[directionIndex].y;
+							if (IsTileSolid(tracer.tiles, tileCount, nx, ny)) {
+								u32 neighbourIndex = ComputeTileIndex(tileCount, nx, ny);
+								if (context.tileComponents[neighbourIndex] == TILETRACE_NO_COMPONENT) {
+									context.tileComponents[neighbourIndex] = component;
+									fillStack.push_back(neighbourIndex);
+								}
+							}
+						}
+					}
+					componentTileCounts.push_back(componentTileCount);
+				}
+			}
+
+			// Merge components which touches by a corner, the root is always the first component in raster order
+			u32 componentCount = (u32)context.componentStartTiles.size();
+			std::vector<u32> parents = std::vector<u32>(componentCount);
+			for (u32 component = 0; component < componentCount; ++component) {
+				parents[component] = component;
+			}
+			for (u32 candidateIndex = 0; candidateIndex < candidateCount; ++candidateIndex) {
+				u32 tileIndex = isRegion ? context.regionTiles[candidateIndex] : candidateIndex;
+				u32 component = context.tileComponents[tileIndex];
+				if (component == TILETRACE_NO_COMPONENT) {
+					continue;
+				}
+				const TileTraceTile &tile = tracer.tiles[tileIndex];
+				const s32 diagonalX[] = { tile.x - 1, tile.x + 1 };
+				for (u32 diagonalIndex = 0; diagonalIndex < ArrayCount(diagonalX); ++diagonalIndex) {
+					if (IsTileSolid(tracer.tiles, tileCount, diagonalX[diagonalIndex], tile.y + 1)) {
+						u32 otherComponent = context.tileComponents[ComputeTileIndex(tileCount, diagonalX[diagonalIndex], tile.y + 1)];
+						u32 rootA = FindComponentRoot(parents, component);
+						u32 rootB = FindComponentRoot(parents, otherComponent);
+						if (rootA < rootB) {
+							parents[rootB] = rootA;
+						} else if (rootB < rootA) {
+							parents[rootA] = rootB;
+						}
+					}
+				}
+			}
+
+			// Groups are ordered by their first component, the components inside a group stays in raster order
+			context.componentGroups.resize(componentCount);
+			context.groups.clear();
+			for (u32 component = 0; component < componentCount; ++component) {
+				u32 root = FindComponentRoot(parents, component);
+				if (root == component) {
+					context.componentGroups[component] = (u32)context.groups.size();
+					TileTraceGroup newGroup = {};
+					newGroup.key = context.componentStartTiles[component];
+					context.groups.push_back(newGroup);
+				} else {
+					context.componentGroups[component] = context.componentGroups[root];
+				}
+				TileTraceGroup &group = context.groups[context.componentGroups[component]];
+				++group.componentCount;
+				group.tileCount += componentTileCounts[component];
+			}
+			u32 groupOffset = 0;
+			for (u32 groupIndex = 0; groupIndex < context.groups.size(); ++groupIndex) {
+				TileTraceGroup &group = context.groups[groupIndex];
+				group.firstComponent = groupOffset;
+				groupOffset += group.componentCount;
+				group.componentCount = 0;
+			}
+			context.groupComponents.resize(componentCount);
+			for (u32 component = 0; component < componentCount; ++component) {
+				TileTraceGroup &group = context.groups[context.componentGroups[component]];
+				context.groupComponents[group.firstComponent + group.componentCount++] = component;
+			}
+		}
+
+		static void ResetHashTable(TileHashTable &table, const u32 capacity) {
+			// Reuse the memory from the previous group, when it is large enough
+			if (table.memory.base != nullptr && table.memory.size >= sizeof(TileHashEntry) * capacity) {
+				table.memory.offset = 0;
+				table.entries = mem::PushArray<TileHashEntry>(&table.memory, capacity, false);
+				for (u32 entryIndex = 0; entryIndex < capacity; ++entryIndex) {
+					table.entries[entryIndex].value = TILETRACE_HASH_EMPTY;
+				}
+				table.capacity = capacity;
+				table.count = 0;
+				table.usedCount = 0;
+			} else {
+				ReleaseHashTable(table);
+				InitHashTable(table, capacity);
+			}
+		}
+
+		static void TraceTileGroup(TileTracer &scratch, TileTraceParallelContext &context, const TileTraceGroup &group, TileTraceBatchResult &result) {
+			TileTracer &tracer = *context.tracer;
+
+			u32 hashCapacity = 16;
+			while (hashCapacity < group.tileCount * 2) {
+				hashCapacity *= 2;
+			}
+			ResetHashTable(scratch.vertexHash, hashCapacity);
+			ResetHashTable(scratch.edgeHash, hashCapacity);
+			scratch.openList.clear();
+			scratch.mainVertices.clear();
+			scratch.mainEdges.clear();
+			scratch.chainSegments.clear();
+			scratch.chainVertices.clear();
+
+			// @NOTE: Each tile belongs to exactly one group, so the workers never touches the same tiles
+			for (u32 groupComponentIndex = 0; groupComponentIndex < group.componentCount; ++groupComponentIndex) {
+				u32 component = context.groupComponents[group.firstComponent + groupComponentIndex];
+				TileTraceTile *startTile = &tracer.tiles[context.componentStartTiles[component]];
+				AddTile(scratch, tracer.tiles, startTile);
+				FloodFillTiles(scratch, tracer.tiles);
+			}
+
+			BuildEdgeTraversal(scratch);
+			scratch.curStep = TileTraceStep::TraverseFindStartingEdge;
+			while (ProcessTraverseFindStartingEdge(scratch)) {
+				const Vec2i &startTilePosition = scratch.startEdge->tilePosition;
+				u32 startComponent = context.tileComponents[ComputeTileIndex(tracer.tileCount, startTilePosition.x, startTilePosition.y)];
+				result.chainSortKeys.push_back(context.componentStartTiles[startComponent]);
+				result.chainGroupKeys.push_back(group.key);
+				while (scratch.curStep == TileTraceStep::TraverseNextEdge) {
+					ProcessTraverseNextEdge(scratch);
+				}
+			}
+			assert(result.chainSortKeys.size() == result.chainSegments.size() + scratch.chainSegments.size());
+
+			u32 vertexOffset = (u32)result.chainVertices.size();
+			for (u32 segmentIndex = 0; segmentIndex < scratch.chainSegments.size(); ++segmentIndex) {
+				TileTraceChainSegment segment = scratch.chainSegments[segmentIndex];
+				for (u32 vertexIndex = 0; vertexIndex < segment.vertexCount; ++vertexIndex) {
+					result.chainVertices.push_back(scratch.GetChainSegmentVertex(segment, vertexIndex));
+				}
+				segment.firstVertex = vertexOffset;
+				vertexOffset += segment.vertexCount;
+				result.chainSegments.push_back(segment);
+			}
+		}
+
+		static void TraceTileGroups(const u32 startIndex, const u32 endIndex, void *userData) {
+			TileTraceParallelContext *context = (TileTraceParallelContext *)userData;
+
+			// Scratch tracer for this batch, the vertex and edge tables are reused for every group in it
+			TileTracer scratch = {};
+			scratch.tileCount = context->tracer->tileCount;
+
+			TileTraceBatchResult &result = context->batchResults[startIndex / context->batchSize];
+			for (u32 groupIndex = startIndex; groupIndex < endIndex; ++groupIndex) {
+				TraceTileGroup(scratch, *context, context->groups[groupIndex], result);
+			}
+
+			scratch.Release();
+		}
+
+		static void TraceAllTileGroups(TileTraceParallelContext &context, concurrency::WorkerPool *workerPool) {
+			u32 groupCount = (u32)context.groups.size();
+			u32 threadCount = workerPool != nullptr ? workerPool->GetThreadCount() : 1;
+			context.batchSize = groupCount / (threadCount * 8);
+			if (context.batchSize == 0) {
+				context.batchSize = 1;
+			}
+			context.batchResults.resize((groupCount + context.batchSize - 1) / context.batchSize);
+			if (workerPool != nullptr) {
+				workerPool->ParallelFor(groupCount, context.batchSize, TraceTileGroups, &context);
+			} else {
+				TraceTileGroups(0, groupCount, &context);
+			}
+		}
+
+		static void MergeChainSegments(TileTracer &tracer, const std::vector<TileTraceBatchResult> &batchResults) {
+			// Merge the chain segments in the same order as Run() would produce them, groups with a equal key keeps the local order
+			struct ChainSegmentRef {
+				u32 sortKey;
+				u32 batchIndex;
+				u32 segmentIndex;
+			};
+			std::vector<ChainSegmentRef> segmentRefs;
+			u32 totalVertexCount = 0;
+			for (u32 batchIndex = 0; batchIndex < batchResults.size(); ++batchIndex) {
+				const TileTraceBatchResult &batchResult = batchResults[batchIndex];
+				for (u32 segmentIndex = 0; segmentIndex < batchResult.chainSegments.size(); ++segmentIndex) {
+					segmentRefs.push_back({ batchResult.chainSortKeys[segmentIndex], batchIndex, segmentIndex });
+				}
+				totalVertexCount += (u32)batchResult.chainVertices.size();
+			}
+			std::stable_sort(segmentRefs.begin(), segmentRefs.end(), [](const ChainSegmentRef &a, const ChainSegmentRef &b) {
+				return a.sortKey < b.sortKey;
+			});
+
+			tracer.chainSegments.clear();
+			tracer.chainVertices.clear();
+			tracer.chainSortKeys.clear();
+			tracer.chainGroupKeys.clear();
+			tracer.chainSegments.reserve(segmentRefs.size());
+			tracer.chainVertices.reserve(totalVertexCount);
+			for (u32 refIndex = 0; refIndex < segmentRefs.size(); ++refIndex) {
+				const ChainSegmentRef &ref = segmentRefs[refIndex];
+				const TileTraceBatchResult &batchResult = batchResults[ref.batchIndex];
+				TileTraceChainSegment segment = batchResult.chainSegments[ref.segmentIndex];
+				u32 sourceFirstVertex = segment.firstVertex;
+				segment.firstVertex = (u32)tracer.chainVertices.size();
+				tracer.chainVertices.insert(tracer.chainVertices.end(), batchResult.chainVertices.begin() + sourceFirstVertex, batchResult.chainVertices.begin() + sourceFirstVertex + segment.vertexCount);
+				tracer.chainSegments.push_back(segment);
+				tracer.chainSortKeys.push_back(ref.sortKey);
+				tracer.chainGroupKeys.push_back(batchResult.chainGroupKeys[ref.segmentIndex]);
+			}
+		}
+
+		static void StoreTileGroupKeys(TileTracer &tracer, const TileTraceParallelContext &context) {
+			u32 candidateCount = context.regionTiles.size() > 0 ? (u32)context.regionTiles.size() : (u32)tracer.tiles.size();
+			for (u32 candidateIndex = 0; candidateIndex < candidateCount; ++candidateIndex) {
+				u32 tileIndex = context.regionTiles.size() > 0 ? context.regionTiles[candidateIndex] : candidateIndex;
+				u32 component = context.tileComponents[tileIndex];
+				if (component != TILETRACE_NO_COMPONENT) {
+					tracer.tileGroupKeys[tileIndex] = context.groups[context.componentGroups[component]].key;
+				}
+			}
+		}
+
+		void TileTracer::RunParallel(concurrency::WorkerPool *workerPool) {
+			assert(curStep == TileTraceStep::FindStart);
+
+			TileTraceParallelContext context = {};
+			context.tracer = this;
+			LabelTileGroups(context);
+			TraceAllTileGroups(context, workerPool);
+			MergeChainSegments(*this, context.batchResults);
+
+			tileGroupKeys.assign(tiles.size(), TILETRACE_NO_COMPONENT);
+			StoreTileGroupKeys(*this, context);
+			dirtyTiles.clear();
+
+			curTile = nullptr;
+			nextTile = nullptr;
+			curStep = TileTraceStep::Done;
+		}
+
+		void TileTracer::ChangeTile(const u32 x, const u32 y, const b32 isSolid) {
+			assert(curStep == TileTraceStep::Done);
+			TileTraceTile *tile = GetTile(tiles, tileCount, x, y);
+			if ((tile->isSolid != 0) != (isSolid != 0)) {
+				tile->isSolid = isSolid ? 1 : 0;
+				dirtyTiles.push_back(Vec2u(x, y));
+			}
+		}
+
+		void TileTracer::RetraceDirtyTiles(concurrency::WorkerPool *workerPool) {
+			assert(curStep == TileTraceStep::Done);
+			assert(chainGroupKeys.size() == chainSegments.size());
+			if (dirtyTiles.size() == 0) {
+				return;
+			}
+
+			// A changed tile can only merge or split the groups touching it, including itself
+			std::vector<u32> affectedGroupKeys;
+			for (u32 dirtyIndex = 0; dirtyIndex < dirtyTiles.size(); ++dirtyIndex) {
+				const Vec2u &dirtyTile = dirtyTiles[dirtyIndex];
+				for (s32 offsetY = -1; offsetY <= 1; ++offsetY) {
+					for (s32 offsetX = -1; offsetX <= 1; ++offsetX) {
+						s32 x = (s32)dirtyTile.x + offsetX;
+						s32 y = (s32)dirtyTile.y + offsetY;
+						if ((x >= 0 && x < (s32)tileCount.w) && (y >= 0 && y < (s32)tileCount.h)) {
+							u32 groupKey = tileGroupKeys[ComputeTileIndex(tileCount, x, y)];
+							if (groupKey != TILETRACE_NO_COMPONENT) {
+								affectedGroupKeys.push_back(groupKey);
+							}
+						}
+					}
+				}
+			}
+			std::sort(affectedGroupKeys.begin(), affectedGroupKeys.end());
+			affectedGroupKeys.erase(std::unique(affectedGroupKeys.begin(), affectedGroupKeys.end()), affectedGroupKeys.end());
+
+			// Collect all tiles of the affected groups and the new solid tiles, these are traced again.
+			// Changed tiles are marked solid already, all other tiles was removed by the previous trace and needs to be restored.
+			// @SPEED: This is a linear scan over the full map, but that is cheap compared to tracing it
+			TileTraceParallelContext context = {};
+			context.tracer = this;
+			for (u32 tileIndex = 0; tileIndex < tiles.size(); ++tileIndex) {
+				TileTraceTile &tile = tiles[tileIndex];
+				u32 groupKey = tileGroupKeys[tileIndex];
+				bool isAffected = groupKey != TILETRACE_NO_COMPONENT && std::binary_search(affectedGroupKeys.begin(), affectedGroupKeys.end(), groupKey);
+				if (isAffected) {
+					tileGroupKeys[tileIndex] = TILETRACE_NO_COMPONENT;
+				}
+				if (tile.isSolid > 0 || (isAffected && tile.isSolid != 0)) {
+					tile = MakeTile(tile.x, tile.y, 1);
+					context.regionTiles.push_back(tileIndex);
+				}
+			}
+			for (u32 dirtyIndex = 0; dirtyIndex < dirtyTiles.size(); ++dirtyIndex) {
+				const Vec2u &dirtyTile = dirtyTiles[dirtyIndex];
+				tileGroupKeys[ComputeTileIndex(tileCount, dirtyTile.x, dirtyTile.y)] = TILETRACE_NO_COMPONENT;
+			}
+			dirtyTiles.clear();
+
+			// The chain segments of all other groups are kept as they are
+			TileTraceBatchResult keptResult = {};
+			for (u32 segmentIndex = 0; segmentIndex < chainSegments.size(); ++segmentIndex) {
+				if (!std::binary_search(affectedGroupKeys.begin(), affectedGroupKeys.end(), chainGroupKeys[segmentIndex])) {
+					TileTraceChainSegment segment = chainSegments[segmentIndex];
+					keptResult.chainVertices.insert(keptResult.chainVertices.end(), chainVertices.begin() + segment.firstVertex, chainVertices.begin() + segment.firstVertex + segment.vertexCount);
+					segment.firstVertex = (u32)keptResult.chainVertices.size() - segment.vertexCount;
+					keptResult.chainSegments.push_back(segment);
+					keptResult.chainSortKeys.push_back(chainSortKeys[segmentIndex]);
+					keptResult.chainGroupKeys.push_back(chainGroupKeys[segmentIndex]);
+				}
+			}
+
+			if (context.regionTiles.size() > 0) {
+				LabelTileGroups(context);
+				TraceAllTileGroups(context, workerPool);
+				StoreTileGroupKeys(*this, context);
+			}
+
+			// @NOTE: Kept and new chains never have the same sort key, because they belongs to different components
+			context.batchResults.push_back(keptResult);
+			MergeChainSegments(*this, context.batchResults);
+		}
+
+		// Returns true when both tracers have the same chain segments with the same vertices in the same order
+		static bool AreChainsEqual(const TileTracer &a, const TileTracer &b) {
+			if (a.chainSegments.size() != b.chainSegments.size()) {
+				return false;
+			}
+			for (u32 segmentIndex = 0; segmentIndex < a.chainSegments.size(); ++segmentIndex) {
+				const TileTraceChainSegment &segmentA = a.chainSegments[segmentIndex];
+				const TileTraceChainSegment &segmentB = b.chainSegments[segmentIndex];
+				if (segmentA.vertexCount != segmentB.vertexCount) {
+					return false;
+				}
+				for (u32 vertexIndex = 0; vertexIndex < segmentA.vertexCount; ++vertexIndex) {
+					const Vec2i &vertexA = a.GetChainSegmentVertex(segmentA, vertexIndex);
+					const Vec2i &vertexB = b.GetChainSegmentVertex(segmentB, vertexIndex);
+					if ((vertexA.x != vertexB.x) || (vertexA.y != vertexB.y)) {
+						return false;
+					}
+				}
+			}
+			return true;
+		}
+
+		void RunTileTraceBenchmark(const u32 maxMapSize, const u32 iterationCount) {
+			assert(maxMapSize >= 32);
+			assert(iterationCount > 0);
+			if (!InitPlatform(InitFlags::None)) {
+				return;
+			}
+
+			concurrency::WorkerPool *workerPool = new concurrency::WorkerPool();
+			workerPool->Init();
+
+			console::ConsoleFormatOut("Tile trace benchmark, %u iterations, %u threads\n", iterationCount, workerPool->GetThreadCount());
+			console::ConsoleFormatOut("Map size Solid tiles Chains Step [ms] Run [ms] RunParallel [ms] Retrace [ms]\n");
+			randoms::RandomSeries series = randoms::RandomSeed(1337);
+			for (u32 mapSize = 32; mapSize <= maxMapSize; mapSize *= 2) {
+				// Random maps with roughly 40% solid tiles, so there are a lot of small and large groups
+				Vec2u tileCount = Vec2u(mapSize, mapSize);
+				std::vector<u8> mapTiles(mapSize * mapSize);
+				u32 solidTileCount = 0;
+				for (u32 tileIndex = 0; tileIndex < mapTiles.size(); ++tileIndex) {
+					mapTiles[tileIndex] = randoms::RandomIndex(series, 100) < 40 ? 1 : 0;
+					solidTileCount += mapTiles[tileIndex];
+				}
+
+				f64 stepTime = 0.0;
+				f64 runTime = 0.0;
+				f64 parallelTime = 0.0;
+				f64 retraceTime = 0.0;
+				u32 chainCount = 0;
+				bool isEqual = true;
+				for (u32 iteration = 0; isEqual && (iteration < iterationCount); ++iteration) {
+					// Step tracer, the same path the visualization uses
+					TileTracer stepTracer = {};
+					stepTracer.Init(tileCount, &mapTiles[0]);
+					f64 startTime = timings::GetHighResolutionTimeInSeconds();
+					while (stepTracer.NextStep()) {
+					}
+					stepTime += timings::GetHighResolutionTimeInSeconds() - startTime;
+
+					TileTracer runTracer = {};
+					runTracer.Init(tileCount, &mapTiles[0]);
+					startTime = timings::GetHighResolutionTimeInSeconds();
+					runTracer.Run();
+					runTime += timings::GetHighResolutionTimeInSeconds() - startTime;
+
+					TileTracer parallelTracer = {};
+					parallelTracer.Init(tileCount, &mapTiles[0]);
+					startTime = timings::GetHighResolutionTimeInSeconds();
+					parallelTracer.RunParallel(workerPool);
+					parallelTime += timings::GetHighResolutionTimeInSeconds() - startTime;
+					chainCount = (u32)parallelTracer.chainSegments.size();
+
+					isEqual = AreChainsEqual(stepTracer, runTracer) && AreChainsEqual(stepTracer, parallelTracer);
+
+					// Change a few random tiles, the retrace must produce the same chains as tracing the changed map from scratch
+					std::vector<u8> changedTiles = mapTiles;
+					u32 changeCount = Maximum(mapSize / 8, 1u);
+					for (u32 changeIndex = 0; changeIndex < changeCount; ++changeIndex) {
+						u32 x = randoms::RandomIndex(series, mapSize);
+						u32 y = randoms::RandomIndex(series, mapSize);
+						u32 tileIndex = ComputeTileIndex(tileCount, x, y);
+						changedTiles[tileIndex] = changedTiles[tileIndex] ? 0 : 1;
+						parallelTracer.ChangeTile(x, y, changedTiles[tileIndex]);
+					}
+					startTime = timings::GetHighResolutionTimeInSeconds();
+					parallelTracer.RetraceDirtyTiles(workerPool);
+					retraceTime += timings::GetHighResolutionTimeInSeconds() - startTime;
+
+					TileTracer changedTracer = {};
+					changedTracer.Init(tileCount, &changedTiles[0]);
+					changedTracer.RunParallel(workerPool);
+					isEqual = isEqual && AreChainsEqual(changedTracer, parallelTracer);
+
+					changedTracer.Release();
+					parallelTracer.Release();
+					runTracer.Release();
+					stepTracer.Release();
+				}
+
+				if (!isEqual) {
+					console::ConsoleFormatOut("%8u Failed, the tracers produces different chains!\n", mapSize);
+					continue;
+				}
+				f64 scale = 1000.0 / (f64)iterationCount;
+				console::ConsoleFormatOut("%8u %11u %6u %9.3f %8.3f %16.3f %12.3f\n", mapSize, solidTileCount, chainCount, stepTime * scale, runTime * scale, parallelTime * scale, retraceTime * scale);
+			}
+
+			workerPool->Shutdown();
+			delete workerPool;
+			ReleasePlatform();
+		}
 	}
 }
\ No newline at end of file
@@ -4,10 +4,12 @@
 
 #include "final_types.h"
 #include "final_maths.h"
+#include "final_mem.h"
+#include "final_concurrency.h"
 
-using namespace finalspace::maths;
+using namespace fs::maths;
 
-namespace finalspace {
+namespace fs {
 	namespace tiletracer {
 		enum class TileTraceDirection {
 			Up,
@@ -51,8 +53,25 @@ namespace finalspace {
 			u32 count;
 		};
 
+		struct TileHashEntry {
+			u64 key;
+			s32 value;
+		};
+
+		// Open addressing hash table with linear probing, which maps a 64-bit key to a index
+		struct TileHashTable {
+			mem::MemoryBlock memory;
+			TileHashEntry *entries;
+			u32 capacity;
+			// Number of live entries
+			u32 count;
+			// Number of live and removed entries
+			u32 usedCount;
+		};
+
+		// Range of vertices in TileTracer::chainVertices
 		struct TileTraceChainSegment {
-			Vec2i vertices[64];
+			u32 firstVertex;
 			u32 vertexCount;
 		};
 
@@ -67,12 +86,55 @@ namespace finalspace {
 			TileTraceEdge *lastEdge;
 			TileTraceChainSegment *curChainSegment;
 			std::vector<TileTraceTile *> openList;
+			// Raster scan position for the next start tile, tiles before it are never solid again
+			u32 scanTileIndex;
 			std::vector<Vec2i> mainVertices;
 			std::vector<TileTraceEdge> mainEdges;
 			std::vector<TileTraceChainSegment> chainSegments;
+			// Vertices for all chain segments, the current segment is always at the end
+			std::vector<Vec2i> chainVertices;
+			// Lattice coordinate to index in mainVertices
+			TileHashTable vertexHash = {};
+			// Vertex index pair to index in mainEdges, for all edges which are not cancelled
+			TileHashTable edgeHash = {};
+			// Outgoing edges for each vertex, built before the traversal starts
+			std::vector<u32> vertexEdgeOffsets;
+			std::vector<u32> vertexEdges;
+			u32 nextStartEdgeIndex;
+			// Group for each tile, which is the first tile index of the group in raster order or UINT32_MAX for no group.
+			// Only filled by RunParallel(), the same for the keys below.
+			std::vector<u32> tileGroupKeys;
+			// Start tile index of the owning component for each chain segment
+			std::vector<u32> chainSortKeys;
+			// Group key for each chain segment
+			std::vector<u32> chainGroupKeys;
+			// Tiles changed since the last trace
+			std::vector<Vec2u> dirtyTiles;
 
 			void Init(const Vec2u &tileCount, u8 *mapTiles);
+			void Release();
+			// Executes a single step of the trace, used for visualizing the algorithm
 			bool NextStep();
+			// Traces the full map at once and produces the same chain segments as calling NextStep() until it is done
+			void Run();
+			// Same as Run(), but all groups of touching tiles are traced in parallel on the worker pool.
+			// Only the chain segments are produced, the main vertices and edges stays empty.
+			void RunParallel(concurrency::WorkerPool *workerPool);
+			// Changes the solid state of a tile after RunParallel(), the tile is traced again in RetraceDirtyTiles()
+			void ChangeTile(const u32 x, const u32 y, const b32 isSolid);
+			// Traces only the groups touching a changed tile again and keeps all other chain segments.
+			// Produces the same chain segments as calling Init() and RunParallel() on the changed map.
+			void RetraceDirtyTiles(concurrency::WorkerPool *workerPool);
+
+			inline const Vec2i &GetChainSegmentVertex(const TileTraceChainSegment &segment, const u32 index) const {
+				assert(index < segment.vertexCount);
+				return chainVertices[segment.firstVertex + index];
+			}
 		};
+
+		// Traces random maps from 32x32 up to maxMapSize with the step tracer, Run() and RunParallel() and prints the average time of each to the console.
+		// Afterwards a few random tiles are changed and RetraceDirtyTiles() is checked against a full RunParallel() of the changed map.
+		// Initializes the platform by itself, so it cannot run next to a game.
+		extern void RunTileTraceBenchmark(const u32 maxMapSize, const u32 iterationCount);
 	};
 };
\ No newline at end of file
@@ -3,6 +3,10 @@
 #include <assert.h>
 #include "final_types.h"
 
+#if defined(_MSC_VER)
+#	include <intrin.h>
+#endif
+
 namespace fs {
 	namespace utils {
 		template <typename T>
@@ -43,5 +47,34 @@ namespace fs {
 			count = oldListCount - 1;
 		}
 
+		// Returns the index of the lowest set bit, value must not be zero
+		inline u32 CountTrailingZeros64(const u64 value) {
+			assert(value != 0);
+		#if defined(_MSC_VER) && defined(_M_X64)
+			unsigned long result;
+			_BitScanForward64(&result, value);
+			return(result);
+		#elif defined(_MSC_VER)
+			unsigned long result;
+			if (_BitScanForward(&result, (u32)value)) {
+				return(result);
+			}
+			_BitScanForward(&result, (u32)(value >> 32));
+			return(result + 32);
+		#else
+			u32 result = (u32)__builtin_ctzll(value);
+			return(result);
+		#endif
+		}
+
+		// @NOTE: No popcnt instruction here, because it is not available on every x64 cpu
+		inline u32 PopCount64(u64 value) {
+			value = value - ((value >> 1) & 0x5555555555555555ULL);
+			value = (value & 0x3333333333333333ULL) + ((value >> 2) & 0x3333333333333333ULL);
+			value = (value + (value >> 4)) & 0x0F0F0F0F0F0F0F0FULL;
+			u32 result = (u32)((value * 0x0101010101010101ULL) >> 56);
+			return(result);
+		}
+
 	};
 };
@@ -1,10 +1,16 @@
 #define FPL_IMPLEMENTATION
 #include <final_platform_layer.hpp>
+#include <string.h>
+#include <stdlib.h>
 
 #include "pong.h"
 
 int main(int argc, char **args) {
 	fs::games::BaseGame *game = new fs::games::Pong();
-	fs::games::RunGame(game);
+	if (argc > 2 && strcmp(args[1], "-headless") == 0) {
+		fs::games::RunGameHeadless(game, 1280, 720, (fs::u32)atoi(args[2]));
+	} else {
+		fs::games::RunGame(game);
+	}
 	delete game;
 }
\ No newline at end of file
@@ -23,7 +23,7 @@ namespace fs {
 			Vec2f direction = Vec2f(Cosine(angle), Sine(angle));
 			ball.moveable.speed = ball.moveable.initialSpeed;
 			ball.moveable.velocity = direction * ball.moveable.speed;
-			ball.moveable.position = ball.moveable.initialPosition;
+			ball.moveable.position = ball.moveable.previousPosition = ball.moveable.initialPosition;
 			ball.moveable.acceleration = Vec2f();
 		}
 
@@ -74,7 +74,7 @@ namespace fs {
 			paddle.color = color;
 			paddle.moveable.speed = 20.0f;
 			paddle.moveable.initialPosition = (n * planes[planeIndex].distance) + Hadamard(n, paddle.ext) * 2.0f;
-			paddle.moveable.position = paddle.moveable.initialPosition;
+			paddle.moveable.position = paddle.moveable.previousPosition = paddle.moveable.initialPosition;
 			paddles.emplace_back(paddle);
 			u32 result = (u32)(paddles.size() - 1);
 			return(result);
@@ -168,11 +168,13 @@ namespace fs {
 
 		void Pong::MoveEntities(const f32 dt) {
 			// Integrate ball
+			ball.moveable.previousPosition = ball.moveable.position;
 			ball.moveable.delta = 0.5f * ball.moveable.acceleration * (dt * dt) + ball.moveable.velocity * dt;
 			ball.moveable.velocity = ball.moveable.acceleration * dt + ball.moveable.velocity;
 
 			// Integrate paddles
 			for (Paddle &paddle : paddles) {
+				paddle.moveable.previousPosition = paddle.moveable.position;
 				paddle.moveable.delta = 0.5f * paddle.moveable.acceleration * (dt * dt) + paddle.moveable.velocity * dt;
 				paddle.moveable.velocity = paddle.moveable.acceleration * dt + paddle.moveable.velocity;
 			}
@@ -214,15 +216,13 @@ namespace fs {
 						f32 minkowskiTop = (paddle.ext.h + ball.radius);
 						f32 minkowskiBottom = -(paddle.ext.h + ball.radius);
 
-						constexpr u32 segmentCount = 4;
-						DeltaPlane2D paddleSegments[segmentCount] = {
-							{ minkowskiRight, relativePosition.x, relativePosition.y, ball.moveable.delta.x, ball.moveable.delta.y, minkowskiBottom, minkowskiTop, Vec2f(1, 0) },
-							{ minkowskiLeft, relativePosition.x, relativePosition.y, ball.moveable.delta.x, ball.moveable.delta.y, minkowskiBottom, minkowskiTop, Vec2f(-1, 0) },
-							{ minkowskiTop, relativePosition.y, relativePosition.x, ball.moveable.delta.y, ball.moveable.delta.x, minkowskiLeft, minkowskiRight, Vec2f(0, 1) },
-							{ minkowskiBottom, relativePosition.y, relativePosition.x, ball.moveable.delta.y, ball.moveable.delta.x, minkowskiLeft, minkowskiRight, Vec2f(0, -1) },
-						};
+						DeltaPlane2Dx4 paddleSegments = {};
+						paddleSegments.Set(0, { minkowskiRight, relativePosition.x, relativePosition.y, ball.moveable.delta.x, ball.moveable.delta.y, minkowskiBottom, minkowskiTop, Vec2f(1, 0) });
+						paddleSegments.Set(1, { minkowskiLeft, relativePosition.x, relativePosition.y, ball.moveable.delta.x, ball.moveable.delta.y, minkowskiBottom, minkowskiTop, Vec2f(-1, 0) });
+						paddleSegments.Set(2, { minkowskiTop, relativePosition.y, relativePosition.x, ball.moveable.delta.y, ball.moveable.delta.x, minkowskiLeft, minkowskiRight, Vec2f(0, 1) });
+						paddleSegments.Set(3, { minkowskiBottom, relativePosition.y, relativePosition.x, ball.moveable.delta.y, ball.moveable.delta.x, minkowskiLeft, minkowskiRight, Vec2f(0, -1) });
 
-						IntersectionResult intersection = IntersectLines(tMin, EpsilonTime, segmentCount, paddleSegments);
+						IntersectionResult intersection = IntersectLinesx4(tMin, EpsilonTime, paddleSegments);
 						if (intersection.wasHit) {
 							f32 f = intersection.tMin;
 							if ((f >= 0.0f) && (tMin > f)) {
@@ -314,7 +314,7 @@ namespace fs {
 			MoveEntities(input.deltaTime);
 		}
 
-		void Pong::Render(const Input &input) {
+		void Pong::Render(const Input &input, const f32 alpha) {
 			const f32 dt = input.deltaTime;
 
 			renderer->Update(GAME_WIDTH * 0.5f, GAME_HEIGHT * 0.5f, GAME_ASPECT);
@@ -323,7 +323,8 @@ namespace fs {
 			renderer->DrawRectangle(Vec2f(0, 0), Vec2f(GAME_WIDTH, GAME_HEIGHT) * 0.5f, Vec4f::White, false, 2.0f);
 
 			for (const Paddle &paddle : paddles) {
-				renderer->DrawRectangle(paddle.moveable.position, paddle.ext, paddle.color, true, 2.0f);
+				Vec2f paddlePosition = Lerp(paddle.moveable.previousPosition, alpha, paddle.moveable.position);
+				renderer->DrawRectangle(paddlePosition, paddle.ext, paddle.color, true, 2.0f);
 			}
 
 			for (const Plane &plane : planes) {
@@ -335,7 +336,8 @@ namespace fs {
 				renderer->DrawLine(center, center + plane.normal * NormalArrowSize, Vec4f::Red, 2.0f);
 			}
 
-			renderer->DrawCircle(ball.moveable.position, ball.radius, ball.color, true, 16, 2.0f);
+			Vec2f ballPosition = Lerp(ball.moveable.previousPosition, alpha, ball.moveable.position);
+			renderer->DrawCircle(ballPosition, ball.radius, ball.color, true, 16, 2.0f);
 
 			renderer->EndFrame();
 		}
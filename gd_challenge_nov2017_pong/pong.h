@@ -31,6 +31,8 @@ namespace fs {
 		struct Moveable {
 			Vec2f initialPosition = Vec2f();
 			Vec2f position = Vec2f();
+			// Position before the last update step, for interpolating while rendering
+			Vec2f previousPosition = Vec2f();
 			Vec2f velocity = Vec2f();
 			Vec2f acceleration = Vec2f();
 			Vec2f delta = Vec2f();
@@ -118,7 +120,7 @@ namespace fs {
 			void Release() override;
 			void HandleInput(const Input &input) override;
 			void Update(const Input &input) override;
-			void Render(const Input &input) override;
+			void Render(const Input &input, const f32 alpha) override;
 		};
 	};
 };
\ No newline at end of file
@@ -1,5 +1,7 @@
 #include "game.h"
 
+#include <algorithm>
+
 #include <final_platform_layer.hpp>
 
 #define STB_IMAGE_IMPLEMENTATION
@@ -51,8 +53,11 @@ namespace fs {
 
 			void Game::Release() {
 				controlledPlayers.clear();
-				players.clear();
-				walls.clear();
+				ClearEntities(players);
+				ClearEntities(enemies);
+				walls.Clear();
+				entityStore.Release();
+				mem::ReleaseMemoryBlock(&levelMemory);
 
 				// @Temporary: Remove this later, the renderer should take care of that automatically
 				ReleaseTexture(renderer, tilesetTexture);
@@ -83,8 +88,8 @@ namespace fs {
 			ResultTilePosition Game::FindFreePlayerTile() {
 				ResultTilePosition result = {};
 
-				for (u32 tileY = 0; tileY < TILE_COUNT_FOR_HEIGHT; ++tileY) {
-					for (u32 tileX = 0; tileX < TILE_COUNT_FOR_WIDTH; ++tileX) {
+				for (u32 tileY = 0; tileY < tileMap.height; ++tileY) {
+					for (u32 tileX = 0; tileX < tileMap.width; ++tileX) {
 						const Tile &tile = GetTile(tileX, tileY);
 						if (tile.type == TileType::Player) {
 							// @TODO: Find tile where is most far away from existing entities
@@ -105,26 +110,27 @@ namespace fs {
 				enemy.ai.nextType = nextType;
 			}
 
-			EnemyIndex Game::CreateEnemy(u32 tileX, u32 tileY) {
+			EnemyHandle Game::CreateEnemy(u32 tileX, u32 tileY) {
 				Vec2f enemyCenterOnTile = TileToWorld(tileX, tileY);
 
 				Entity enemy = Entity();
 				enemy.ext = Vec2f(0.3f, 0.3f);
-				enemy.position = enemyCenterOnTile - Vec2f(0, TILE_SIZE * 0.5f) + Vec2f(0, enemy.ext.y + EntityPlaceOffset);
 				enemy.type = Entity::Type::Enemy;
 				enemy.color = Vec4f(1.0f, 0.0f, 1.0f);
 				enemy.horizontalSpeed = 2.0f;
-				enemy.horizontalDrag = 4.0f;
 				enemy.canJump = true;
 				enemy.jumpPower = 120.0f;
 				NextAIDecision(enemy, 1.0f, AIState::Type::DecideDirection);
 
-				u32 result = (u32)enemies.size();
-				enemies.emplace_back(enemy);
+				EnemyHandle result = enemies.Add(enemy);
+				Entity *addedEnemy = enemies.Get(result);
+				addedEnemy->storeIndex = MAX_PLAYER_COUNT + result.index;
+				Vec2f position = enemyCenterOnTile - Vec2f(0, TILE_SIZE * 0.5f) + Vec2f(0, enemy.ext.y + EntityPlaceOffset);
+				entityStore.Activate(addedEnemy->storeIndex, position, 4.0f);
 				return(result);
 			}
 
-			PlayerIndex Game::CreatePlayer(const u32 controllerIndex) {
+			PlayerHandle Game::CreatePlayer(const u32 controllerIndex) {
 				ResultTilePosition resultPos = FindFreePlayerTile();
 				assert(resultPos.found);
 				Vec2f playerCenterOnTile = TileToWorld(resultPos.tileX, resultPos.tileY);
@@ -133,17 +139,27 @@ namespace fs {
 				player.type = Entity::Type::Player;
 				player.color = Vec4f(1.0f, 1.0f, 1.0f, 1.0f);
 				player.ext = Vec2f(0.4f, 0.4f);
-				player.position = playerCenterOnTile - Vec2f(0, TILE_SIZE * 0.5f) + Vec2f(0, player.ext.y + EntityPlaceOffset);
 				player.horizontalSpeed = 20.0f;
-				player.horizontalDrag = 13.0f;
 				player.canJump = true;
 				player.jumpPower = 140.0f;
 
-				u32 result = (u32)players.size();
-				players.emplace_back(player);
+				PlayerHandle result = players.Add(player);
+				Entity *addedPlayer = players.Get(result);
+				addedPlayer->storeIndex = result.index;
+				Vec2f position = playerCenterOnTile - Vec2f(0, TILE_SIZE * 0.5f) + Vec2f(0, player.ext.y + EntityPlaceOffset);
+				entityStore.Activate(addedPlayer->storeIndex, position, 13.0f);
 				return(result);
 			}
 
+			void Game::ClearEntities(mem::Pool<Entity> &entities) {
+				for (u32 entitySlot = 0; entitySlot < entities.GetSlotCount(); ++entitySlot) {
+					if (entities.IsSlotUsed(entitySlot)) {
+						entityStore.Deactivate(entities.GetSlot(entitySlot).storeIndex);
+					}
+				}
+				entities.Clear();
+			}
+
 			s32 Game::FindControlledPlayerIndex(const u32 controllerIndex) {
 				s32 result = -1;
 				for (u32 controlledPlayerIndex = 0; controlledPlayerIndex < controlledPlayers.size(); ++controlledPlayerIndex) {
@@ -162,20 +178,21 @@ namespace fs {
 						// @NOTE: Connected controller
 						s32 foundControlledPlayerIndex = FindControlledPlayerIndex(controllerIndex);
 						if (foundControlledPlayerIndex == -1) {
-							u32 playerIndex;
-							if (isSinglePlayer) {
-								if (players.size() == 0) {
-									playerIndex = CreatePlayer(controllerIndex);
-								} else {
-									playerIndex = 0;
+							PlayerHandle playerHandle = {};
+							if (isSinglePlayer && players.GetCount() > 0) {
+								// All controllers share the first player
+								for (u32 slotIndex = 0; slotIndex < players.GetSlotCount(); ++slotIndex) {
+									if (players.IsSlotUsed(slotIndex)) {
+										playerHandle = players.GetSlotHandle(slotIndex);
+										break;
+									}
 								}
-							} else {
-								// @TODO: Limit the number of players
-								playerIndex = CreatePlayer(controllerIndex);
+							} else if (players.GetCount() < players.GetCapacity()) {
+								playerHandle = CreatePlayer(controllerIndex);
 							}
 							ControlledPlayer controlledPlayer = {};
 							controlledPlayer.controllerIndex = controllerIndex;
-							controlledPlayer.playerIndex = playerIndex;
+							controlledPlayer.playerHandle = playerHandle;
 							controlledPlayers.emplace_back(controlledPlayer);
 						}
 					} else {
@@ -183,13 +200,15 @@ namespace fs {
 						s32 foundControlledPlayerIndex = FindControlledPlayerIndex(controllerIndex);
 						if (foundControlledPlayerIndex != -1) {
 							const ControlledPlayer &controlledPlayer = controlledPlayers[foundControlledPlayerIndex];
-							u32 playerIndex = controlledPlayer.playerIndex;
-							u32 controllerIndex = controlledPlayer.controllerIndex;
 
 							// @TODO: Give the player a bit time to reconnect - let it blink or something
 
-							// Remove player and controlled player
-							players.erase(players.begin() + playerIndex);
+							// Remove player and controlled player, other controllers sharing the player just have a invalid handle then
+							Entity *player = players.Get(controlledPlayer.playerHandle);
+							if (player != nullptr) {
+								entityStore.Deactivate(player->storeIndex);
+								players.Remove(controlledPlayer.playerHandle);
+							}
 							controlledPlayers.erase(controlledPlayers.begin() + foundControlledPlayerIndex);
 						}
 					}
@@ -201,9 +220,9 @@ namespace fs {
 				return result;
 			}
 
-			static void Jump(Entity &entity) {
+			static void Jump(EntityStore &store, Entity &entity) {
 				if (CanJump(entity)) {
-					entity.acceleration.y += 1.0f * entity.jumpPower;
+					store.accelerationY[entity.storeIndex] += 1.0f * entity.jumpPower;
 					entity.moveDirection.y = 1;
 					++entity.jumpCount;
 				}
@@ -215,8 +234,11 @@ namespace fs {
 				constexpr f32 ReflectCoolDown = 0.01f;
 				constexpr f32 ToMoveCoolDown = 0.1f;
 
-				for (u32 enemyIndex = 0; enemyIndex < enemies.size(); ++enemyIndex) {
-					Entity &enemy = enemies[enemyIndex];
+				for (u32 enemySlot = 0; enemySlot < enemies.GetSlotCount(); ++enemySlot) {
+					if (!enemies.IsSlotUsed(enemySlot)) {
+						continue;
+					}
+					Entity &enemy = enemies.GetSlot(enemySlot);
 
 					if (enemy.ai.isWaiting) {
 						enemy.ai.waitRemaingTime -= deltaTime;
@@ -247,7 +269,7 @@ namespace fs {
 							}
 
 							Vec2f acc = enemy.moveDirection * enemy.horizontalSpeed;
-							enemy.acceleration += acc;
+							entityStore.AddAcceleration(enemy.storeIndex, acc);
 						} break;
 
 						case AIState::Type::DecideDirection:
@@ -266,7 +288,7 @@ namespace fs {
 
 						case AIState::Type::Jump:
 						{
-							Jump(enemy);
+							Jump(entityStore, enemy);
 							NextAIDecision(enemy, 0.0f, AIState::Type::Move);
 						} break;
 					}
@@ -279,171 +301,255 @@ namespace fs {
 			void Game::ProcessPlayerInput(const Input &input) {
 				// Player forces
 				for (u32 controlledPlayerIndex = 0; controlledPlayerIndex < controlledPlayers.size(); ++controlledPlayerIndex) {
-					u32 playerIndex = controlledPlayers[controlledPlayerIndex].playerIndex;
+					PlayerHandle playerHandle = controlledPlayers[controlledPlayerIndex].playerHandle;
 					u32 controllerIndex = controlledPlayers[controlledPlayerIndex].controllerIndex;
 
-					// @BUG: On app shutdown this crashes due to the assert below.
-					// Players got cleared but connected controllers arent,
-					// because the controller is not disconnected when shutting down.
-					// This condition ensures that it wont crash, but its not correct!
-					if (playerIndex >= (players.size())) continue;
+					// @NOTE: The player may be removed already, for example when the map was cleared or the shared player was disconnected
+					Entity *playerPtr = players.Get(playerHandle);
+					if (playerPtr == nullptr) continue;
 
-					assert(playerIndex < players.size());
 					assert(controllerIndex < utils::ArrayCount(input.controllers));
 
-					Entity &player = players[playerIndex];
+					Entity &player = *playerPtr;
 					const Controller &playerController = input.controllers[controllerIndex];
 
 					// Set acceleration based on player input
 					player.moveDirection = Vec2f();
 					if (!playerController.isAnalog) {
 						if (playerController.moveLeft.isDown) {
-							player.acceleration.x += -1.0f * player.horizontalSpeed;
+							entityStore.accelerationX[player.storeIndex] += -1.0f * player.horizontalSpeed;
 							player.moveDirection.x = -1;
 						} else if (playerController.moveRight.isDown) {
-							player.acceleration.x += 1.0f * player.horizontalSpeed;
+							entityStore.accelerationX[player.storeIndex] += 1.0f * player.horizontalSpeed;
 							player.moveDirection.x = 1;
 						}
 					} else {
 						if (playerController.analogMovement.x != 0) {
-							player.acceleration.x += playerController.analogMovement.x * player.horizontalSpeed;
+							entityStore.accelerationX[player.storeIndex] += playerController.analogMovement.x * player.horizontalSpeed;
 						}
 					}
 
 					// Jump
 					if (playerController.actionDown.isDown) {
-						Jump(player);
+						Jump(entityStore, player);
 					}
 				}
 			}
 
-			void Game::MoveEntities(std::vector<Entity> &entities, const f32 deltaTime) {
-				for (s32 entityIndex = 0; entityIndex < entities.size(); ++entityIndex) {
-					Entity &entity = entities[entityIndex];
-
-					entity.isGrounded = false;
-					entity.collisionCount = 0;
-
-					// Movement equation:
-					// p' = (a / 2) * dt^2 + v * dt + p
-					// v' = a * dt + v
-					Vec2f deltaMovement = 0.5f * entity.acceleration * (deltaTime * deltaTime) + entity.velocity * deltaTime;
-					entity.velocity = entity.acceleration * deltaTime + entity.velocity;
-					entity.acceleration = Vec2f();
-
-					// Do line segment tests for each wall, find the side of the wall which is nearest in time
-					// To support colliding with multiple walls we iterate a few times
-					for (u32 iteration = 0; iteration < 4; ++iteration) {
-						f32 tmin = 1.0f;
-						f32 tmax = 1.0f;
-
-						f32 deltaMovementLen = Length(deltaMovement);
-						if (deltaMovementLen > 0.0f) {
-
-							Vec2f wallNormalMin = Vec2f();
-							Wall *hitWallMin = nullptr;
-
-							Vec2f targetPosition = entity.position + deltaMovement;
+			void Game::IntegrateEntities(const u32 startIndex, const u32 endIndex, const f32 deltaTime) {
+				// Movement equation:
+				// p' = (a / 2) * dt^2 + v * dt + p
+				// v' = a * dt + v
+				// @NOTE: The position is not changed here, the movement is applied by the collision sweep in MoveEntity()
+				assert((startIndex % 4) == 0 && (endIndex % 4) == 0);
+				EntityStore &store = entityStore;
+			#if MATH_ENABLE_SSE2
+				const __m128 half = _mm_set1_ps(0.5f);
+				const __m128 dt = _mm_set1_ps(deltaTime);
+				const __m128 dtSquared = _mm_set1_ps(deltaTime * deltaTime);
+				const __m128 zero = _mm_setzero_ps();
+				for (u32 index = startIndex; index < endIndex; index += 4) {
+					_mm_store_ps(store.previousPositionX + index, _mm_load_ps(store.positionX + index));
+					_mm_store_ps(store.previousPositionY + index, _mm_load_ps(store.positionY + index));
+					__m128 accelerationX = _mm_load_ps(store.accelerationX + index);
+					__m128 accelerationY = _mm_load_ps(store.accelerationY + index);
+					__m128 velocityX = _mm_load_ps(store.velocityX + index);
+					__m128 velocityY = _mm_load_ps(store.velocityY + index);
+					_mm_store_ps(store.movementX + index, _mm_add_ps(_mm_mul_ps(_mm_mul_ps(half, accelerationX), dtSquared), _mm_mul_ps(velocityX, dt)));
+					_mm_store_ps(store.movementY + index, _mm_add_ps(_mm_mul_ps(_mm_mul_ps(half, accelerationY), dtSquared), _mm_mul_ps(velocityY, dt)));
+					_mm_store_ps(store.velocityX + index, _mm_add_ps(_mm_mul_ps(accelerationX, dt), velocityX));
+					_mm_store_ps(store.velocityY + index, _mm_add_ps(_mm_mul_ps(accelerationY, dt), velocityY));
+					_mm_store_ps(store.accelerationX + index, zero);
+					_mm_store_ps(store.accelerationY + index, zero);
+				}
+			#else
+				for (u32 index = startIndex; index < endIndex; ++index) {
+					store.previousPositionX[index] = store.positionX[index];
+					store.previousPositionY[index] = store.positionY[index];
+					store.movementX[index] = 0.5f * store.accelerationX[index] * (deltaTime * deltaTime) + store.velocityX[index] * deltaTime;
+					store.movementY[index] = 0.5f * store.accelerationY[index] * (deltaTime * deltaTime) + store.velocityY[index] * deltaTime;
+					store.velocityX[index] = store.accelerationX[index] * deltaTime + store.velocityX[index];
+					store.velocityY[index] = store.accelerationY[index] * deltaTime + store.velocityY[index];
+					store.accelerationX[index] = 0.0f;
+					store.accelerationY[index] = 0.0f;
+				}
+			#endif
+			}
 
-							for (u32 wallIndex = 0; wallIndex < walls.size(); ++wallIndex) {
-								Wall &wall = walls[wallIndex];
+			void Game::MoveEntity(Entity &entity) {
+				// @NOTE: Only the entity itself and its entry in the entity store are written, walls and tiles are read only.
+				// So entities can be moved in any order and on any thread, with the exact same results.
+				entity.isGrounded = false;
+				entity.collisionCount = 0;
+
+				const u32 storeIndex = entity.storeIndex;
+				Vec2f position = entityStore.GetPosition(storeIndex);
+				Vec2f velocity = entityStore.GetVelocity(storeIndex);
+				Vec2f deltaMovement = Vec2f(entityStore.movementX[storeIndex], entityStore.movementY[storeIndex]);
+
+				// Do line segment tests for each wall, find the side of the wall which is nearest in time
+				// To support colliding with multiple walls we iterate a few times
+				for (u32 iteration = 0; iteration < 4; ++iteration) {
+					f32 tmin = 1.0f;
+					f32 tmax = 1.0f;
+
+					f32 deltaMovementLen = Length(deltaMovement);
+					if (deltaMovementLen > 0.0f) {
+
+						Vec2f wallNormalMin = Vec2f();
+						WallHandle hitWallMin = {};
+
+						Vec2f targetPosition = position + deltaMovement;
+
+						// @NOTE: Only walls inside the swept area can be hit, so we just visit the tiles covered by it.
+						// Tiles are visited in raster order, so the results are identical to testing all walls in the order of their tiles.
+						Vec2f sweptMin = Minimum(position, targetPosition) - entity.ext - TILE_EXT;
+						Vec2f sweptMax = Maximum(position, targetPosition) + entity.ext + TILE_EXT;
+						Vec2i sweptMinTile = WorldToTile(sweptMin);
+						Vec2i sweptMaxTile = WorldToTile(sweptMax);
+						s32 minTileX = Clamp(sweptMinTile.x - 1, 0, (s32)tileMap.width - 1);
+						s32 minTileY = Clamp(sweptMinTile.y - 1, 0, (s32)tileMap.height - 1);
+						s32 maxTileX = Clamp(sweptMaxTile.x + 1, 0, (s32)tileMap.width - 1);
+						s32 maxTileY = Clamp(sweptMaxTile.y + 1, 0, (s32)tileMap.height - 1);
+
+						for (s32 tileY = minTileY; tileY <= maxTileY; ++tileY) {
+							for (s32 tileX = minTileX; tileX <= maxTileX; ++tileX) {
+								WallHandle wallHandle = wallTileHandles[tileMap.GetTileIndex(tileX, tileY)];
+								const Wall *wall = walls.Get(wallHandle);
+								if (wall == nullptr) {
+									continue;
+								}
 
-								Vec2f minkowskiExt = { entity.ext.x + wall.ext.x, entity.ext.y + wall.ext.y };
+								Vec2f minkowskiExt = { entity.ext.x + wall->ext.x, entity.ext.y + wall->ext.y };
 								Vec2f minCorner = -minkowskiExt;
 								Vec2f maxCorner = minkowskiExt;
 
-								Vec2f rel = entity.position - wall.position;
-
-								DeltaPlane2D testSides[4];
-								u32 sideCount = 0;
-								testSides[sideCount++] = { minCorner.x, rel.x, rel.y, deltaMovement.x, deltaMovement.y, minCorner.y, maxCorner.y,{ -1, 0 } };
-								testSides[sideCount++] = { maxCorner.x, rel.x, rel.y, deltaMovement.x, deltaMovement.y, minCorner.y, maxCorner.y,{ 1, 0 } };
-								testSides[sideCount++] = { minCorner.y, rel.y, rel.x, deltaMovement.y, deltaMovement.x, minCorner.x, maxCorner.x,{ 0, -1 } };
-								testSides[sideCount++] = { maxCorner.y, rel.y, rel.x, deltaMovement.y, deltaMovement.x, minCorner.x, maxCorner.x,{ 0, 1 } };
+								Vec2f rel = position - wall->position;
 
-								if (wall.isPlatform) {
-									// @NOTE: One a platform we just have to test for the upper side.
-									sideCount = 1;
-									testSides[0] = { maxCorner.y, rel.y, rel.x, deltaMovement.y, deltaMovement.x, minCorner.x, maxCorner.x,{ 0, 1 } };
+								DeltaPlane2Dx4 testSides = {};
+								if (wall->isPlatform) {
+									// @NOTE: One a platform we just have to test for the upper side, the other planes stays zero and are skipped.
+									testSides.Set(0, { maxCorner.y, rel.y, rel.x, deltaMovement.y, deltaMovement.x, minCorner.x, maxCorner.x,{ 0, 1 } });
+								} else {
+									testSides.Set(0, { minCorner.x, rel.x, rel.y, deltaMovement.x, deltaMovement.y, minCorner.y, maxCorner.y,{ -1, 0 } });
+									testSides.Set(1, { maxCorner.x, rel.x, rel.y, deltaMovement.x, deltaMovement.y, minCorner.y, maxCorner.y,{ 1, 0 } });
+									testSides.Set(2, { minCorner.y, rel.y, rel.x, deltaMovement.y, deltaMovement.x, minCorner.x, maxCorner.x,{ 0, -1 } });
+									testSides.Set(3, { maxCorner.y, rel.y, rel.x, deltaMovement.y, deltaMovement.x, minCorner.x, maxCorner.x,{ 0, 1 } });
 								}
 
 								// @TODO: It works but i would prefered a generic line segment intersection test here
 								// Create line segments for each sides of a tile
 								constexpr f32 EpsilonTime = 0.001f;
-								IntersectionResult intersectionResult = IntersectLines(tmin, EpsilonTime, sideCount, testSides);
+								IntersectionResult intersectionResult = IntersectLinesx4(tmin, EpsilonTime, testSides);
 								if (intersectionResult.wasHit) {
 									// Solid block or one sided platform
-									if ((!wall.isPlatform) || (wall.isPlatform && (Dot(deltaMovement, Vec2f::Up) <= 0))) {
+									if ((!wall->isPlatform) || (wall->isPlatform && (Dot(deltaMovement, Vec2f::Up) <= 0))) {
 										tmin = intersectionResult.tMin;
 										wallNormalMin = intersectionResult.normal;
-										hitWallMin = &wall;
+										hitWallMin = wallHandle;
 									}
 								}
 							}
+						}
 
-							Vec2f wallNormal = Vec2f();
-							Wall *hitWall = nullptr;
-							f32 stopTime;
-							if (tmin < tmax) {
-								stopTime = tmin;
-								hitWall = hitWallMin;
-								wallNormal = wallNormalMin;
-							} else {
-								stopTime = tmax;
-							}
-
-							entity.position += stopTime * deltaMovement;
+						Vec2f wallNormal = Vec2f();
+						WallHandle hitWall = {};
+						f32 stopTime;
+						if (tmin < tmax) {
+							stopTime = tmin;
+							hitWall = hitWallMin;
+							wallNormal = wallNormalMin;
+						} else {
+							stopTime = tmax;
+						}
 
-							if (hitWall != nullptr) {
-								// Recalculate player delta and apply bounce (canceling out the velocity along the normal)
-								f32 restitution = 0.0f;
-								deltaMovement = targetPosition - entity.position;
-								deltaMovement += -(1 + restitution) * Dot(deltaMovement, wallNormal) * wallNormal;
-								entity.velocity += -(1 + restitution) * Dot(entity.velocity, wallNormal) * wallNormal;
+						position += stopTime * deltaMovement;
 
-								// Update grounded states
-								if (Dot(wallNormal, Vec2f::Up) > 0) {
-									entity.isGrounded = true;
-									entity.jumpCount = 0;
-								}
+						if (walls.IsValid(hitWall)) {
+							// Recalculate player delta and apply bounce (canceling out the velocity along the normal)
+							f32 restitution = 0.0f;
+							deltaMovement = targetPosition - position;
+							deltaMovement += -(1 + restitution) * Dot(deltaMovement, wallNormal) * wallNormal;
+							velocity += -(1 + restitution) * Dot(velocity, wallNormal) * wallNormal;
 
-								// Add collision state
-								assert(entity.collisionCount < utils::ArrayCount(entity.collisions));
-								u32 collisionIndex = entity.collisionCount++;
-								CollisionState *collision = &entity.collisions[collisionIndex];
-								*collision = {};
-								collision->isColliding = true;
-								collision->wall = hitWall;
-								collision->normal = wallNormal;
+							// Update grounded states
+							if (Dot(wallNormal, Vec2f::Up) > 0) {
+								entity.isGrounded = true;
+								entity.jumpCount = 0;
 							}
+
+							// Add collision state
+							assert(entity.collisionCount < utils::ArrayCount(entity.collisions));
+							u32 collisionIndex = entity.collisionCount++;
+							CollisionState *collision = &entity.collisions[collisionIndex];
+							*collision = {};
+							collision->isColliding = true;
+							collision->wall = hitWall;
+							collision->normal = wallNormal;
 						}
 					}
 				}
-			}
-
-			void Game::SetExternalForces() {
-				// External forces (Gravity, drag, etc.)
-				for (s32 playerIndex = 0; playerIndex < players.size(); ++playerIndex) {
-					Entity &player = players[playerIndex];
-					player.acceleration = Vec2f();
 
-					// Gravity
-					player.acceleration += gravity;
+				entityStore.SetPosition(storeIndex, position);
+				entityStore.SetVelocity(storeIndex, velocity);
+			}
 
-					// Horizontal drag
-					player.acceleration += -Dot(Vec2f::Right, player.velocity) * Vec2f::Right * player.horizontalDrag;
+			struct EntityUpdateContext {
+				Game *game;
+				f32 deltaTime;
+			};
+
+			// Integrates and moves the entities in a range of entity store blocks, one block contains four entities
+			static void UpdateEntityBlocks(const u32 startIndex, const u32 endIndex, void *userData) {
+				EntityUpdateContext *context = (EntityUpdateContext *)userData;
+				Game *game = context->game;
+				u32 startStoreIndex = startIndex * 4;
+				u32 endStoreIndex = endIndex * 4;
+				game->IntegrateEntities(startStoreIndex, endStoreIndex, context->deltaTime);
+				for (u32 storeIndex = startStoreIndex; storeIndex < endStoreIndex; ++storeIndex) {
+					Entity *entity = game->GetStoreEntity(storeIndex);
+					if (entity != nullptr) {
+						game->MoveEntity(*entity);
+					}
 				}
+			}
 
-				for (s32 enemyIndex = 0; enemyIndex < enemies.size(); ++enemyIndex) {
-					Entity &enemy = enemies[enemyIndex];
-					enemy.acceleration = Vec2f();
-
-					// Gravity
-					enemy.acceleration += gravity;
+			void Game::UpdateEntities(const f32 deltaTime) {
+				EntityUpdateContext updateContext = {};
+				updateContext.game = this;
+				updateContext.deltaTime = deltaTime;
+				u32 blockCount = GetEntityStoreCount() / 4;
+				if (workerPool != nullptr) {
+					workerPool->ParallelFor(blockCount, ENTITY_UPDATE_BATCH_SIZE, UpdateEntityBlocks, &updateContext);
+				} else {
+					UpdateEntityBlocks(0, blockCount, &updateContext);
+				}
+			}
 
-					// Horizontal drag
-					enemy.acceleration += -Dot(Vec2f::Right, enemy.velocity) * Vec2f::Right * enemy.horizontalDrag;
+			void Game::SetExternalForces() {
+				// External forces (Gravity, drag, etc.) for players and enemies, unused entities are masked out
+				const u32 count = GetEntityStoreCount();
+				EntityStore &store = entityStore;
+			#if MATH_ENABLE_SSE2
+				const __m128 gravityX = _mm_set1_ps(gravity.x);
+				const __m128 gravityY = _mm_set1_ps(gravity.y);
+				for (u32 index = 0; index < count; index += 4) {
+					__m128 activeMask = _mm_load_ps(store.activeMask + index);
+					__m128 velocityX = _mm_load_ps(store.velocityX + index);
+					__m128 horizontalDrag = _mm_load_ps(store.horizontalDrag + index);
+
+					// Gravity and horizontal drag
+					__m128 accelerationX = _mm_sub_ps(gravityX, _mm_mul_ps(velocityX, horizontalDrag));
+					_mm_store_ps(store.accelerationX + index, _mm_mul_ps(accelerationX, activeMask));
+					_mm_store_ps(store.accelerationY + index, _mm_mul_ps(gravityY, activeMask));
 				}
+			#else
+				for (u32 index = 0; index < count; ++index) {
+					// Gravity and horizontal drag
+					store.accelerationX[index] = (gravity.x - store.velocityX[index] * store.horizontalDrag[index]) * store.activeMask[index];
+					store.accelerationY[index] = gravity.y * store.activeMask[index];
+				}
+			#endif
 			}
 
 			static ImRect CreateNormalizedRect(const ImVec2 &min, ImVec2 &max) {
@@ -467,8 +573,10 @@ namespace fs {
 				// Menu
 				if (ImGui::BeginMenuBar()) {
 					if (ImGui::BeginMenu("File")) {
+						ImGui::InputInt2("New map size", &newMapSize.x);
+						newMapSize = Vec2i(Clamp(newMapSize.x, 1, (s32)MAX_TILE_COUNT_FOR_WIDTH), Clamp(newMapSize.y, 1, (s32)MAX_TILE_COUNT_FOR_HEIGHT));
 						if (ImGui::MenuItem("New map")) {
-							ClearMap();
+							ResizeMap(newMapSize.x, newMapSize.y);
 							activeEditorFilePath = "";
 						}
 						if (ImGui::MenuItem("Load map...")) {
@@ -527,7 +635,8 @@ namespace fs {
 					Vec2f canvasMin = Vec2f(minRegion.x, maxRegion.y);
 					Vec2f canvasMax = Vec2f(maxRegion.x, minRegion.y);
 
-					RenderArea canvasArea = CalculateRenderArea(-Vec2f(HALF_GAME_WIDTH, HALF_GAME_HEIGHT), Vec2f(HALF_GAME_WIDTH, HALF_GAME_HEIGHT), canvasMin, canvasMax, true);
+					const Vec2f tileMapExt = GetTileMapExt();
+					RenderArea canvasArea = CalculateRenderArea(-tileMapExt, tileMapExt, canvasMin, canvasMax, true);
 
 					ImVec2 actualCanvasMin = ImVec2(canvasArea.targetMin.x, canvasArea.targetMin.y);
 					ImVec2 actualCanvasMax = ImVec2(canvasArea.targetMax.x, canvasArea.targetMax.y);
@@ -536,9 +645,9 @@ namespace fs {
 					ImDrawList* draw_list = ImGui::GetWindowDrawList();
 
 					// Draw tiles
-					for (u32 y = 0; y < TILE_COUNT_FOR_HEIGHT; ++y) {
-						for (u32 x = 0; x < TILE_COUNT_FOR_WIDTH; ++x) {
-							const Tile &tile = tiles[y * TILE_COUNT_FOR_WIDTH + x];
+					for (u32 y = 0; y < tileMap.height; ++y) {
+						for (u32 x = 0; x < tileMap.width; ++x) {
+							const Tile &tile = GetTile(x, y);
 							if (tile.type != TileType::None) {
 								s32 tileTypeIndex = (s32)tile.type;
 								Vec2f uvMax = TileUVs[tileTypeIndex * 2 + 0];
@@ -554,10 +663,13 @@ namespace fs {
 					}
 
 					// Draw players
-					for (u32 playerIndex = 0; playerIndex < players.size(); ++playerIndex) {
-						const Entity &player = players[playerIndex];
+					for (u32 playerSlot = 0; playerSlot < players.GetSlotCount(); ++playerSlot) {
+						if (!players.IsSlotUsed(playerSlot)) {
+							continue;
+						}
+						const Entity &player = players.GetSlot(playerSlot);
 						Vec4f playerColor = Vec4f(1.0f, 1.0f, 1.0f);
-						Vec2f playerPos = player.position - player.ext;
+						Vec2f playerPos = entityStore.GetPosition(player.storeIndex) - player.ext;
 						Vec2f a = canvasArea.Project(playerPos);
 						Vec2f b = canvasArea.Project(playerPos + player.ext * 2.0f);
 						draw_list->AddRectFilled(ImVec2(a.x, a.y), ImVec2(b.x, b.y), ImColor(playerColor.r, playerColor.g, playerColor.b, playerColor.a));
@@ -585,7 +697,7 @@ namespace fs {
 						}
 						draw_list->AddRect(ImVec2(a.x, a.y), ImVec2(b.x, b.y), ImColor(255, 255, 100));
 
-						if (ImGui::IsMouseDown(0)) {
+						if (ImGui::IsMouseDown(0) && IsValidTilePosition(hoverTile)) {
 							SetTile(hoverTile.x, hoverTile.y, selectedTileType);
 						}
 					}
@@ -669,157 +781,689 @@ namespace fs {
 
 			}
 
+			void Game::ResizeMap(const u32 width, const u32 height) {
+				assert(width > 0 && height > 0);
+				assert(width <= MAX_TILE_COUNT_FOR_WIDTH && height <= MAX_TILE_COUNT_FOR_HEIGHT);
+				tileMap.Resize(width, height);
+				tileChunks.clear();
+				tileChunks.resize(tileMap.chunkCountForWidth * tileMap.chunkCountForHeight);
+				wallTileHandles.resize(tileMap.tiles.size());
+				enemies.Release();
+				enemies.Init((u32)tileMap.tiles.size());
+				entityStore.Release();
+				entityStore.Init(MAX_PLAYER_COUNT + (u32)tileMap.tiles.size());
+				walls.Release();
+				walls.Init((u32)tileMap.tiles.size());
+				ClearMap();
+			}
+
 			void Game::ClearMap() {
-				for (u32 tileIndex = 0; tileIndex < tiles.size(); ++tileIndex)
-					tiles[tileIndex] = {};
-				players.clear();
-				enemies.clear();
-				walls.clear();
+				tileMap.Clear();
+				ClearEntities(players);
+				ClearEntities(enemies);
+				walls.Clear();
+				ClearWallTileHandles();
 				controlledPlayers.clear();
+				InvalidateTileChunks();
+				dirtyTiles.clear();
+				isFullReloadRequired = true;
+			}
+			//
+			// Map file format (version 2):
+			// MapFileHeader, followed by a MapFileChunk for each chunk and then the data of all chunks.
+			// The map is split into square chunks of tiles, stored row by row with one byte per tile type.
+			// Each chunk is stored either raw or run length encoded, whatever is smaller.
+			//
+			// The legacy format has the tile count right after the magic id, followed by a 32-bit tile type for every tile.
+			//
+			enum class MapChunkCompression : u32 {
+				None = 0,
+				RLE = 1,
+			};
+
+			struct MapFileHeader {
+				char magic[4];
+				u32 version;
+				u32 width;
+				u32 height;
+				u32 chunkSize;
+				u32 chunkCount;
+			};
+
+			struct MapFileChunk {
+				// Offset to the chunk data from the start of the file
+				u32 offset;
+				u32 size;
+				MapChunkCompression compression;
+			};
+
+			// Encodes the tiles as pairs of run length and tile type, returns zero when the result does not fit
+			static u32 EncodeMapChunkRLE(const u8 *source, const u32 sourceSize, u8 *dest, const u32 maxDestSize) {
+				u32 result = 0;
+				u32 sourceIndex = 0;
+				while (sourceIndex < sourceSize) {
+					u8 value = source[sourceIndex];
+					u32 runLength = 1;
+					while (runLength < 255 && sourceIndex + runLength < sourceSize && source[sourceIndex + runLength] == value) {
+						++runLength;
+					}
+					if (result + 2 > maxDestSize) {
+						return 0;
+					}
+					dest[result++] = (u8)runLength;
+					dest[result++] = value;
+					sourceIndex += runLength;
+				}
+				return(result);
+			}
+
+			static bool DecodeMapChunkRLE(const u8 *source, const u32 sourceSize, u8 *dest, const u32 destSize) {
+				u32 destIndex = 0;
+				for (u32 sourceIndex = 0; sourceIndex + 1 < sourceSize; sourceIndex += 2) {
+					u32 runLength = source[sourceIndex];
+					u8 value = source[sourceIndex + 1];
+					if (runLength == 0 || destIndex + runLength > destSize) {
+						return false;
+					}
+					for (u32 runIndex = 0; runIndex < runLength; ++runIndex) {
+						dest[destIndex++] = value;
+					}
+				}
+				bool result = (destIndex == destSize) && (sourceSize % 2 == 0);
+				return(result);
+			}
+
+			// Tile types stored in a map file, everything above the enemy is not a valid tile
+			static bool IsValidMapTileType(const s32 value) {
+				bool result = (value >= (s32)TileType::None) && (value <= (s32)TileType::Enemy);
+				return(result);
+			}
+
+			static bool LoadLegacyMap(const u8 *fileData, const u32 fileSize, TileMap &tileMap) {
+				assert(tileMap.width == DEFAULT_TILE_COUNT_FOR_WIDTH && tileMap.height == DEFAULT_TILE_COUNT_FOR_HEIGHT);
+				const u32 maxTileCount = DEFAULT_TILE_COUNT_FOR_WIDTH * DEFAULT_TILE_COUNT_FOR_HEIGHT;
+				const u32 headerSize = sizeof(MAP_MAGIC_ID) + sizeof(u32);
+				if (fileSize < headerSize + sizeof(Tile) * maxTileCount) {
+					return false;
+				}
+				const Tile *sourceTiles = (const Tile *)(fileData + headerSize);
+				for (u32 y = 0; y < tileMap.height; ++y) {
+					for (u32 x = 0; x < tileMap.width; ++x) {
+						TileType type = sourceTiles[y * tileMap.width + x].type;
+						if (!IsValidMapTileType((s32)type)) {
+							return false;
+						}
+						tileMap.SetTileType(x, y, type);
+					}
+				}
+				return true;
 			}
+
+			static bool IsValidChunkedMapHeader(const u8 *fileData, const u32 fileSize) {
+				if (fileSize < sizeof(MapFileHeader)) {
+					return false;
+				}
+				const MapFileHeader *header = (const MapFileHeader *)fileData;
+				bool result = header->version == MAP_FILE_VERSION && header->chunkSize > 0 && header->width > 0 && header->height > 0;
+				// @NOTE: The tile map rounds the size up to full chunks, so the tile count is checked on the rounded size in 64-bit.
+				// The chunk size has the same limit, so the chunk decode buffer stays in range as well.
+				if (result && header->width <= MAX_TILE_COUNT_FOR_WIDTH && header->height <= MAX_TILE_COUNT_FOR_HEIGHT && header->chunkSize <= MAX_TILE_COUNT_FOR_WIDTH) {
+					u64 chunkCountForWidth = ((u64)header->width + TILE_CHUNK_SIZE - 1) / TILE_CHUNK_SIZE;
+					u64 chunkCountForHeight = ((u64)header->height + TILE_CHUNK_SIZE - 1) / TILE_CHUNK_SIZE;
+					u64 tileCount = chunkCountForWidth * chunkCountForHeight * TILE_CHUNK_SIZE * TILE_CHUNK_SIZE;
+					result = tileCount <= MAX_TILE_COUNT;
+				} else {
+					result = false;
+				}
+				return(result);
+			}
+
+			static bool LoadChunkedMap(const u8 *fileData, const u32 fileSize, TileMap &tileMap) {
+				assert(IsValidChunkedMapHeader(fileData, fileSize));
+				const MapFileHeader *header = (const MapFileHeader *)fileData;
+				assert(header->width == tileMap.width && header->height == tileMap.height);
+
+				u32 chunkCountForWidth = (header->width + header->chunkSize - 1) / header->chunkSize;
+				u32 chunkCountForHeight = (header->height + header->chunkSize - 1) / header->chunkSize;
+				if (header->chunkCount != chunkCountForWidth * chunkCountForHeight || fileSize < sizeof(MapFileHeader) + sizeof(MapFileChunk) * (u64)header->chunkCount) {
+					return false;
+				}
+
+				// @NOTE: Raw chunks are read directly from the file data, only compressed chunks needs a decode buffer
+				const MapFileChunk *chunks = (const MapFileChunk *)(fileData + sizeof(MapFileHeader));
+				std::vector<u8> chunkTiles = std::vector<u8>(header->chunkSize * header->chunkSize);
+				for (u32 chunkIndex = 0; chunkIndex < header->chunkCount; ++chunkIndex) {
+					const MapFileChunk &chunk = chunks[chunkIndex];
+					if ((u64)chunk.offset + chunk.size > fileSize) {
+						return false;
+					}
+					u32 startX = (chunkIndex % chunkCountForWidth) * header->chunkSize;
+					u32 startY = (chunkIndex / chunkCountForWidth) * header->chunkSize;
+					u32 chunkWidth = Minimum(header->chunkSize, header->width - startX);
+					u32 chunkHeight = Minimum(header->chunkSize, header->height - startY);
+					u32 chunkTileCount = chunkWidth * chunkHeight;
+
+					const u8 *chunkData = fileData + chunk.offset;
+					if (chunk.compression == MapChunkCompression::None) {
+						if (chunk.size != chunkTileCount) {
+							return false;
+						}
+					} else if (chunk.compression == MapChunkCompression::RLE) {
+						if (!DecodeMapChunkRLE(chunkData, chunk.size, &chunkTiles[0], chunkTileCount)) {
+							return false;
+						}
+						chunkData = &chunkTiles[0];
+					} else {
+						return false;
+					}
+
+					for (u32 y = 0; y < chunkHeight; ++y) {
+						for (u32 x = 0; x < chunkWidth; ++x) {
+							u8 type = chunkData[y * chunkWidth + x];
+							if (!IsValidMapTileType(type)) {
+								return false;
+							}
+							tileMap.SetTileType(startX + x, startY + y, (TileType)type);
+						}
+					}
+				}
+				return true;
+			}
+
 			bool Game::LoadMap(const char *filePath) {
 				bool result = false;
 
+				// @NOTE: The platform layer has no memory mapped files, so the whole file is read with a single call instead
 				auto fileHandle = files::OpenBinaryFile(filePath);
 				if (fileHandle.isValid) {
-					u32 read;
-					char magic[4] = {};
-					assert(sizeof(MAP_MAGIC_ID) == sizeof(magic));
-					read = files::ReadFileBlock32(fileHandle, sizeof(magic), &magic, sizeof(magic));
-					assert(read == sizeof(magic) && (strncmp(MAP_MAGIC_ID, magic, utils::ArrayCount(MAP_MAGIC_ID)) == 0));
+					u32 fileSize = files::GetFileSize32(fileHandle);
+					mem::MemoryBlock fileMemory = mem::AllocateMemoryBlock(Maximum(fileSize, 1u));
+					u8 *fileData = mem::PushArray<u8>(&fileMemory, fileSize, false);
+					u32 read = files::ReadFileBlock32(fileHandle, fileSize, fileData, fileSize);
+					files::CloseFile(fileHandle);
 
-					ClearMap();
+					if (read == fileSize && fileSize >= sizeof(MAP_MAGIC_ID) + sizeof(u32) && strncmp(MAP_MAGIC_ID, (const char *)fileData, utils::ArrayCount(MAP_MAGIC_ID)) == 0) {
+						// Legacy maps have the tile count where the version is stored now
+						u32 versionOrTileCount = *(const u32 *)(fileData + sizeof(MAP_MAGIC_ID));
+						if (versionOrTileCount == DEFAULT_TILE_COUNT_FOR_WIDTH * DEFAULT_TILE_COUNT_FOR_HEIGHT) {
+							ResizeMap(DEFAULT_TILE_COUNT_FOR_WIDTH, DEFAULT_TILE_COUNT_FOR_HEIGHT);
+							result = LoadLegacyMap(fileData, fileSize, tileMap);
+						} else if (IsValidChunkedMapHeader(fileData, fileSize)) {
+							const MapFileHeader *header = (const MapFileHeader *)fileData;
+							ResizeMap(header->width, header->height);
+							result = LoadChunkedMap(fileData, fileSize, tileMap);
+						}
+						if (!result) {
+							ClearMap();
+						}
+					}
 
-					u32 tileCount = 0;
-					const u32 maxTileCount = TILE_COUNT_FOR_WIDTH * TILE_COUNT_FOR_HEIGHT;
-					read = files::ReadFileBlock32(fileHandle, sizeof(tileCount), &tileCount, sizeof(tileCount));
-					assert(read == sizeof(tileCount) && tileCount == maxTileCount);
+					mem::ReleaseMemoryBlock(&fileMemory);
+				}
 
-					Tile *firstTile = &tiles[0];
-					read = files::ReadFileBlock32(fileHandle, sizeof(Tile) * tileCount, firstTile, sizeof(Tile) * maxTileCount);
-					assert(read == sizeof(Tile) * maxTileCount);
+				return(result);
+			}
+			void Game::SaveMap(const char *filePath) {
+				const u32 chunkCountForWidth = (tileMap.width + MAP_FILE_CHUNK_SIZE - 1) / MAP_FILE_CHUNK_SIZE;
+				const u32 chunkCountForHeight = (tileMap.height + MAP_FILE_CHUNK_SIZE - 1) / MAP_FILE_CHUNK_SIZE;
+				const u32 chunkCount = chunkCountForWidth * chunkCountForHeight;
+
+				// Build the whole file in memory first, so it can be written with a single call
+				std::vector<u8> fileData = std::vector<u8>(sizeof(MapFileHeader) + sizeof(MapFileChunk) * chunkCount);
+				MapFileHeader header = {};
+				memory::MemoryCopy((void *)MAP_MAGIC_ID, sizeof(MAP_MAGIC_ID), header.magic);
+				header.version = MAP_FILE_VERSION;
+				header.width = tileMap.width;
+				header.height = tileMap.height;
+				header.chunkSize = MAP_FILE_CHUNK_SIZE;
+				header.chunkCount = chunkCount;
+				memory::MemoryCopy(&header, sizeof(header), &fileData[0]);
+
+				std::vector<u8> chunkTiles = std::vector<u8>(MAP_FILE_CHUNK_SIZE * MAP_FILE_CHUNK_SIZE);
+				std::vector<u8> encodedTiles = std::vector<u8>(MAP_FILE_CHUNK_SIZE * MAP_FILE_CHUNK_SIZE);
+				for (u32 chunkIndex = 0; chunkIndex < chunkCount; ++chunkIndex) {
+					u32 startX = (chunkIndex % chunkCountForWidth) * MAP_FILE_CHUNK_SIZE;
+					u32 startY = (chunkIndex / chunkCountForWidth) * MAP_FILE_CHUNK_SIZE;
+					u32 chunkWidth = Minimum(MAP_FILE_CHUNK_SIZE, tileMap.width - startX);
+					u32 chunkHeight = Minimum(MAP_FILE_CHUNK_SIZE, tileMap.height - startY);
+					u32 chunkTileCount = chunkWidth * chunkHeight;
+					for (u32 y = 0; y < chunkHeight; ++y) {
+						for (u32 x = 0; x < chunkWidth; ++x) {
+							TileType type = GetTileType(startX + x, startY + y);
+							assert((s32)type >= 0 && (s32)type <= UINT8_MAX);
+							chunkTiles[y * chunkWidth + x] = (u8)type;
+						}
+					}
 
-					result = true;
+					// Only keep the encoded tiles, when these are smaller than the raw ones
+					MapFileChunk chunk = {};
+					chunk.offset = (u32)fileData.size();
+					const u8 *chunkData = &chunkTiles[0];
+					chunk.size = EncodeMapChunkRLE(&chunkTiles[0], chunkTileCount, &encodedTiles[0], chunkTileCount - 1);
+					if (chunk.size > 0) {
+						chunk.compression = MapChunkCompression::RLE;
+						chunkData = &encodedTiles[0];
+					} else {
+						chunk.compression = MapChunkCompression::None;
+						chunk.size = chunkTileCount;
+					}
+					fileData.insert(fileData.end(), chunkData, chunkData + chunk.size);
+					memory::MemoryCopy(&chunk, sizeof(chunk), &fileData[sizeof(MapFileHeader) + sizeof(MapFileChunk) * chunkIndex]);
+				}
 
+				auto fileHandle = files::CreateBinaryFile(filePath);
+				if (fileHandle.isValid) {
+					files::WriteFileBlock32(fileHandle, &fileData[0], (u32)fileData.size());
 					files::CloseFile(fileHandle);
 				}
+			}
+
+			void Game::ClearWallTileHandles() {
+				for (u32 tileIndex = 0; tileIndex < wallTileHandles.size(); ++tileIndex) {
+					wallTileHandles[tileIndex] = {};
+				}
+			}
 
+			void Game::InvalidateTileChunks() {
+				for (u32 chunkIndex = 0; chunkIndex < tileChunks.size(); ++chunkIndex) {
+					tileChunks[chunkIndex].isDirty = true;
+				}
+			}
+
+			void Game::BuildTileChunk(const u32 chunkX, const u32 chunkY) {
+				TileChunk &chunk = tileChunks[chunkY * tileMap.chunkCountForWidth + chunkX];
+				chunk.vertices.clear();
+				// Only the solid tiles are visited, in the same order as the tiles inside the chunk
+				u64 solidMask = tileMap.solidMasks[chunkY * tileMap.chunkCountForWidth + chunkX];
+				chunk.vertices.reserve(utils::PopCount64(solidMask) * 4);
+				while (solidMask != 0) {
+					u32 bitIndex = utils::CountTrailingZeros64(solidMask);
+					solidMask &= solidMask - 1;
+					u32 x = chunkX * TILE_CHUNK_SIZE + (bitIndex & (TILE_CHUNK_SIZE - 1));
+					u32 y = chunkY * TILE_CHUNK_SIZE + (bitIndex >> TILE_CHUNK_SHIFT);
+					TileType type = GetTileType(x, y);
+					Vec2f uvMax = TileUVs[(s32)type * 2 + 0];
+					Vec2f uvMin = TileUVs[(s32)type * 2 + 1];
+					Vec2f pos = TileToWorld(x, y);
+					chunk.vertices.push_back({ pos + Vec2f(TILE_EXT.w, TILE_EXT.h), Vec2f(uvMax.x, uvMax.y), Vec4f::White });
+					chunk.vertices.push_back({ pos + Vec2f(-TILE_EXT.w, TILE_EXT.h), Vec2f(uvMin.x, uvMax.y), Vec4f::White });
+					chunk.vertices.push_back({ pos + Vec2f(-TILE_EXT.w, -TILE_EXT.h), Vec2f(uvMin.x, uvMin.y), Vec4f::White });
+					chunk.vertices.push_back({ pos + Vec2f(TILE_EXT.w, -TILE_EXT.h), Vec2f(uvMax.x, uvMin.y), Vec4f::White });
+				}
+				chunk.isDirty = false;
+			}
+
+			// Directions for the closest path node search
+			static const Vec2f PATH_NODE_SEARCH_DIRECTIONS[] = {
+				Vec2f(0, 1), // Up
+				Vec2f(-1, 1), // Left-up
+				Vec2f(-1, 0), // Left
+				Vec2f(-1, -1), // Left-down
+				Vec2f(0, -1), // Down
+				Vec2f(1, -1), // Right-Down
+				Vec2f(1, 0), // Right
+				Vec2f(1, 1), // Right-up
+			};
+			constexpr u32 PATH_NODE_SEARCH_DIRECTION_COUNT = 8;
+
+			// Path nodes sorted by the projection on a single search direction
+			struct PathNodeDirectionIndex {
+				u32 *sortedNodes;
+				// Position in sortedNodes for each path node
+				u32 *nodeRanks;
+			};
+
+			struct ClosestNodesContext {
+				Game *game;
+				const PathNodeDirectionIndex *directionIndices;
+				u32 nodeCount;
+				// Path nodes to compute, all nodes when this is null
+				const u32 *nodeIndices;
+			};
+
+			static void ComputeClosestNodes(const u32 startIndex, const u32 endIndex, void *userData) {
+				ClosestNodesContext *context = (ClosestNodesContext *)userData;
+				Game *game = context->game;
+				for (u32 index = startIndex; index < endIndex; ++index) {
+					u32 targetNodeIndex = context->nodeIndices != nullptr ? context->nodeIndices[index] : index;
+					PathNode &targetNode = game->enemyPath[targetNodeIndex];
+
+					for (u32 dirIndex = 0; dirIndex < PATH_NODE_SEARCH_DIRECTION_COUNT; ++dirIndex) {
+						const Vec2f &searchDir = PATH_NODE_SEARCH_DIRECTIONS[dirIndex];
+						const PathNodeDirectionIndex &directionIndex = context->directionIndices[dirIndex];
+
+						// @NOTE: Candidates are visited by increasing projection, so the first visible node is the closest one.
+						// Node positions are tile centers, so the projections are exact and this gives the same node as testing every pair.
+						PathNode *closestNode = nullptr;
+						for (u32 rank = directionIndex.nodeRanks[targetNodeIndex] + 1; rank < context->nodeCount; ++rank) {
+							PathNode &sourceNode = game->enemyPath[directionIndex.sortedNodes[rank]];
+
+							Vec2f relativeDistance = sourceNode.worldPosition - targetNode.worldPosition;
+							f32 proj = Dot(searchDir, relativeDistance);
+							if (proj > 0) {
+								Ray2D ray = Ray2D(targetNode.worldPosition, sourceNode.worldPosition, 1.0f);
+								LineCastResult lineCast = game->DoLineCast(ray);
+								if (!lineCast.isHit) {
+									closestNode = &sourceNode;
+									break;
+								}
+							}
+						}
+
+						assert(dirIndex < utils::ArrayCount(targetNode.closestNodes));
+						targetNode.closestNodes[dirIndex] = closestNode;
+					}
+				}
+			}
+
+			bool Game::IsPathNodeTile(const s32 x, const s32 y) {
+				// Free tile on top of a solid tile, with at least one more tile above it
+				bool result = IsValidTilePosition(x, y - 1) && IsValidTilePosition(x, y + 1) && IsSolid(x, y - 1) && !IsSolid(x, y);
 				return(result);
 			}
-			void Game::SaveMap(const char *filePath) {
-				auto fileHandle = files::CreateBinaryFile(filePath);
-				if (fileHandle.isValid) {
-					files::WriteFileBlock32(fileHandle, (void *)&MAP_MAGIC_ID, sizeof(MAP_MAGIC_ID));
-					u32 tileCount = TILE_COUNT_FOR_WIDTH * TILE_COUNT_FOR_HEIGHT;
-					files::WriteFileBlock32(fileHandle, &tileCount, sizeof(tileCount));
-					for (u32 tileY = 0; tileY < TILE_COUNT_FOR_HEIGHT; ++tileY) {
-						for (u32 tileX = 0; tileX < TILE_COUNT_FOR_WIDTH; ++tileX) {
-							Tile tile = tiles[tileY * TILE_COUNT_FOR_WIDTH + tileX];
-							files::WriteFileBlock32(fileHandle, &tile, sizeof(tile));
+
+			void Game::UpdateClosestNodes(const u32 *nodeIndices, const u32 nodeIndexCount) {
+				assert(utils::ArrayCount(PATH_NODE_SEARCH_DIRECTIONS) == PATH_NODE_SEARCH_DIRECTION_COUNT);
+
+				mem::TemporaryMemory tempMemory = mem::BeginTemporaryMemory(&levelMemory);
+
+				const u32 nodeCount = (u32)enemyPath.size();
+				PathNodeDirectionIndex directionIndices[PATH_NODE_SEARCH_DIRECTION_COUNT];
+				f32 *nodeProjections = mem::PushArray<f32>(&levelMemory, nodeCount, false, 16);
+				for (u32 dirIndex = 0; dirIndex < PATH_NODE_SEARCH_DIRECTION_COUNT; ++dirIndex) {
+					const Vec2f &searchDir = PATH_NODE_SEARCH_DIRECTIONS[dirIndex];
+					PathNodeDirectionIndex &directionIndex = directionIndices[dirIndex];
+					directionIndex.sortedNodes = mem::PushArray<u32>(&levelMemory, nodeCount, false, 16);
+					directionIndex.nodeRanks = mem::PushArray<u32>(&levelMemory, nodeCount, false, 16);
+					for (u32 nodeIndex = 0; nodeIndex < nodeCount; ++nodeIndex) {
+						nodeProjections[nodeIndex] = Dot(searchDir, enemyPath[nodeIndex].worldPosition);
+						directionIndex.sortedNodes[nodeIndex] = nodeIndex;
+					}
+
+					// Sort by projection, equal projections are kept in node order
+					std::sort(directionIndex.sortedNodes, directionIndex.sortedNodes + nodeCount, [nodeProjections](const u32 a, const u32 b) {
+						if (nodeProjections[a] != nodeProjections[b]) {
+							return nodeProjections[a] < nodeProjections[b];
+						}
+						return a < b;
+					});
+					for (u32 rank = 0; rank < nodeCount; ++rank) {
+						directionIndex.nodeRanks[directionIndex.sortedNodes[rank]] = rank;
+					}
+				}
+
+				ClosestNodesContext closestNodesContext = {};
+				closestNodesContext.game = this;
+				closestNodesContext.directionIndices = directionIndices;
+				closestNodesContext.nodeCount = nodeCount;
+				closestNodesContext.nodeIndices = nodeIndices;
+				u32 itemCount = nodeIndices != nullptr ? nodeIndexCount : nodeCount;
+				if (workerPool != nullptr) {
+					workerPool->ParallelFor(itemCount, 16, ComputeClosestNodes, &closestNodesContext);
+				} else {
+					ComputeClosestNodes(0, itemCount, &closestNodesContext);
+				}
+
+				mem::EndTemporaryMemory(&tempMemory);
+			}
+
+			void Game::CreateEnemies() {
+				ClearEntities(enemies);
+				for (u32 y = 0; y < tileMap.height; ++y) {
+					for (u32 x = 0; x < tileMap.width; ++x) {
+						const Tile &tile = GetTile(x, y);
+						if (tile.type == TileType::Enemy) {
+							CreateEnemy(x, y);
 						}
 					}
-					files::CloseFile(fileHandle);
 				}
 			}
 
 			void Game::Reload() {
 				enemyEntropy = RandomSeed(1337);
 
+				InvalidateTileChunks();
+				dirtyTiles.clear();
+				isFullReloadRequired = false;
+
+				// A new level starts, so the level memory only grows when the map has more tiles than before
+				size_t levelMemorySize = GetLevelMemorySize();
+				if (levelMemory.size < levelMemorySize) {
+					mem::ReleaseMemoryBlock(&levelMemory);
+					levelMemory = mem::AllocateMemoryBlock(levelMemorySize, 16, mem::MemoryBlockFlags::GuardPage);
+				} else {
+					mem::ClearMemoryBlock(&levelMemory);
+				}
+
+				// @NOTE: Walls and path nodes are created from the tile map masks, a byte of a chunk mask is one row of tiles.
+				// The rows are visited across all chunks, so everything is still created in the raster order of the tiles.
+				const u32 chunkRowMask = (1 << TILE_CHUNK_SIZE) - 1;
+
 				// Create walls
-				walls.clear();
-				for (u32 y = 0; y < TILE_COUNT_FOR_HEIGHT; ++y) {
-					for (u32 x = 0; x < TILE_COUNT_FOR_WIDTH; ++x) {
-						const Tile &tile = GetTile(x, y);
-						if (tile.type == TileType::Block || tile.type == TileType::Platform) {
+				walls.Clear();
+				ClearWallTileHandles();
+				for (u32 y = 0; y < tileMap.height; ++y) {
+					u32 rowShift = (y & (TILE_CHUNK_SIZE - 1)) * TILE_CHUNK_SIZE;
+					for (u32 chunkX = 0; chunkX < tileMap.chunkCountForWidth; ++chunkX) {
+						u64 rowMask = (tileMap.solidMasks[tileMap.GetChunkIndex(chunkX * TILE_CHUNK_SIZE, y)] >> rowShift) & chunkRowMask;
+						while (rowMask != 0) {
+							u32 x = chunkX * TILE_CHUNK_SIZE + utils::CountTrailingZeros64(rowMask);
+							rowMask &= rowMask - 1;
+							const Tile &tile = GetTile(x, y);
 							Vec2f tileWorldPos = TileToWorld(x, y);
 							Wall wall = {};
 							wall.position = tileWorldPos;
 							wall.ext = TILE_SIZE * 0.5f;
 							wall.isPlatform = tile.type == TileType::Platform;
 							wall.tileType = tile.type;
-							walls.emplace_back(wall);
+							wall.tilePosition = Vec2i(x, y);
+							wallTileHandles[tileMap.GetTileIndex(x, y)] = walls.Add(wall);
 						}
 					}
 				}
 
 				// Create enemies
-				enemies.clear();
-				for (u32 y = 0; y < TILE_COUNT_FOR_HEIGHT; ++y) {
-					for (u32 x = 0; x < TILE_COUNT_FOR_WIDTH; ++x) {
-						const Tile &tile = GetTile(x, y);
-						if (tile.type == TileType::Enemy) {
-							CreateEnemy(x, y);
-						}
-					}
-				}
+				CreateEnemies();
 
-				// Create path nodes
+				// Create path nodes, these are free tiles on top of a solid tile with one more tile above
 				enemyPath.clear();
-				for (u32 y = 0; y < TILE_COUNT_FOR_HEIGHT; ++y) {
-					for (u32 x = 0; x < TILE_COUNT_FOR_WIDTH; ++x) {
-						if (IsSolid(x, y)) {
-							if (IsValidTilePosition(x, y + 1) && IsValidTilePosition(x, y + 2)) {
-								TileType typeAbove1 = GetTileType(x, y + 1);
-								TileType typeAbove2 = GetTileType(x, y + 2);
-								if (typeAbove1 != TileType::Platform && typeAbove1 != TileType::Block) {
-									PathNode node = {};
-									node.tilePosition = Vec2i(x, y + 1);
-									node.worldPosition = TileToWorld(node.tilePosition.x, node.tilePosition.y);
-									enemyPath.emplace_back(node);
-								}
+				mem::TemporaryMemory nodeMasksMemory = mem::BeginTemporaryMemory(&levelMemory);
+				u64 *nodeMasks = mem::PushArray<u64>(&levelMemory, tileMap.chunkCountForWidth, false, 16);
+				for (u32 y = 0; y < tileMap.height; ++y) {
+					u32 rowShift = (y & (TILE_CHUNK_SIZE - 1)) * TILE_CHUNK_SIZE;
+					if (rowShift == 0) {
+						// Node mask for the next row of chunks, the solid row below the first row comes from the chunk below
+						u32 chunkY = y >> TILE_CHUNK_SHIFT;
+						u32 rowCount = Minimum(tileMap.height - 1 - y, TILE_CHUNK_SIZE);
+						u64 validMask = rowCount < TILE_CHUNK_SIZE ? ((1ULL << (rowCount * TILE_CHUNK_SIZE)) - 1) : ~0ULL;
+						for (u32 chunkX = 0; chunkX < tileMap.chunkCountForWidth; ++chunkX) {
+							u32 chunkIndex = chunkY * tileMap.chunkCountForWidth + chunkX;
+							u64 solidMask = tileMap.solidMasks[chunkIndex];
+							u64 solidBelowMask = solidMask << TILE_CHUNK_SIZE;
+							if (chunkY > 0) {
+								solidBelowMask |= tileMap.solidMasks[chunkIndex - tileMap.chunkCountForWidth] >> (64 - TILE_CHUNK_SIZE);
 							}
+							nodeMasks[chunkX] = solidBelowMask & ~solidMask & validMask;
+						}
+					}
+					for (u32 chunkX = 0; chunkX < tileMap.chunkCountForWidth; ++chunkX) {
+						u64 rowMask = (nodeMasks[chunkX] >> rowShift) & chunkRowMask;
+						while (rowMask != 0) {
+							u32 x = chunkX * TILE_CHUNK_SIZE + utils::CountTrailingZeros64(rowMask);
+							rowMask &= rowMask - 1;
+							assert(IsPathNodeTile(x, y));
+							PathNode node = {};
+							node.tilePosition = Vec2i(x, y);
+							node.worldPosition = TileToWorld(node.tilePosition.x, node.tilePosition.y);
+							enemyPath.emplace_back(node);
 						}
 					}
 				}
+				mem::EndTemporaryMemory(&nodeMasksMemory);
 
 				// Compute closest nodes
-				const Vec2f searchDirections[] = {
-					Vec2f(0, 1), // Up
-					Vec2f(-1, 1), // Left-up
-					Vec2f(-1, 0), // Left
-					Vec2f(-1, -1), // Left-down
-					Vec2f(0, -1), // Down
-					Vec2f(1, -1), // Right-Down
-					Vec2f(1, 0), // Right
-					Vec2f(1, 1), // Right-up
-				};
+				UpdateClosestNodes(nullptr, 0);
+			}
 
-				for (u32 targetNodeIndex = 0; targetNodeIndex < enemyPath.size(); ++targetNodeIndex) {
-					PathNode &targetNode = enemyPath[targetNodeIndex];
+			void Game::ReloadDirtyTiles() {
+				if (isFullReloadRequired) {
+					Reload();
+					return;
+				}
 
-					for (u32 dirIndex = 0; dirIndex < utils::ArrayCount(searchDirections); ++dirIndex) {
-						const Vec2f &searchDir = searchDirections[dirIndex];
+				enemyEntropy = RandomSeed(1337);
 
-						PathNode *closestNode = nullptr;
-						f32 closestDistance = F32_MAX;
-						for (u32 sourceNodeIndex = 0; sourceNodeIndex < enemyPath.size(); ++sourceNodeIndex) {
-							if (targetNodeIndex != sourceNodeIndex) {
-								PathNode &sourceNode = enemyPath[sourceNodeIndex];
-								
-								Vec2f relativeDistance = sourceNode.worldPosition - targetNode.worldPosition;
+				// @NOTE: Enemies are game state and not derived from the map, so these are always reset when leaving the editor
+				CreateEnemies();
 
-								Ray2D ray = Ray2D(targetNode.worldPosition, sourceNode.worldPosition, 1.0f);
+				if (dirtyTiles.size() == 0) {
+					return;
+				}
 
-								LineCastResult lineCast = DoLineCast(ray);
+				// @NOTE: The level memory is sized for at most one change per tile, so a lot of changes are rebuild from scratch.
+				// These are not faster than a full reload anyway.
+				if (dirtyTiles.size() > tileMap.width * tileMap.height) {
+					Reload();
+					return;
+				}
+				assert(levelMemory.size >= GetLevelMemorySize());
+				mem::TemporaryMemory tempMemory = mem::BeginTemporaryMemory(&levelMemory);
+
+				// Update walls
+				for (u32 dirtyIndex = 0; dirtyIndex < dirtyTiles.size(); ++dirtyIndex) {
+					const Vec2i &dirtyTile = dirtyTiles[dirtyIndex];
+					u32 tileIndex = tileMap.GetTileIndex(dirtyTile.x, dirtyTile.y);
+					const Tile &tile = GetTile(dirtyTile);
+					bool isWall = tile.type == TileType::Block || tile.type == TileType::Platform;
+					WallHandle wallHandle = wallTileHandles[tileIndex];
+					if (walls.IsValid(wallHandle) && !isWall) {
+						walls.Remove(wallHandle);
+						wallTileHandles[tileIndex] = {};
+					} else if (isWall) {
+						if (!walls.IsValid(wallHandle)) {
+							Wall wall = {};
+							wall.position = TileToWorld(dirtyTile);
+							wall.ext = TILE_SIZE * 0.5f;
+							wall.tilePosition = dirtyTile;
+							wallHandle = walls.Add(wall);
+							wallTileHandles[tileIndex] = wallHandle;
+						}
+						Wall *wall = walls.Get(wallHandle);
+						wall->isPlatform = tile.type == TileType::Platform;
+						wall->tileType = tile.type;
+					}
+				}
 
-								if (!lineCast.isHit) {
-									f32 proj = Dot(searchDir, relativeDistance);
-									if (proj > 0) {
-										if ((closestNode == nullptr) || (proj < closestDistance)) {
-											closestDistance = proj;
-											closestNode = &sourceNode;
-										}
-									}
-								}
+				// A path node depends on its own tile and the tile below, so only these positions can change
+				const u32 dirtyTileCount = (u32)dirtyTiles.size();
+				Vec2i *changedNodeTiles = mem::PushArray<Vec2i>(&levelMemory, dirtyTileCount * 2, false, 16);
+				for (u32 dirtyIndex = 0; dirtyIndex < dirtyTileCount; ++dirtyIndex) {
+					const Vec2i &dirtyTile = dirtyTiles[dirtyIndex];
+					changedNodeTiles[dirtyIndex * 2 + 0] = dirtyTile;
+					changedNodeTiles[dirtyIndex * 2 + 1] = Vec2i(dirtyTile.x, dirtyTile.y + 1);
+				}
+				auto tileOrder = [](const Vec2i &a, const Vec2i &b) {
+					return (a.y < b.y) || (a.y == b.y && a.x < b.x);
+				};
+				std::sort(changedNodeTiles, changedNodeTiles + dirtyTileCount * 2, tileOrder);
+				const u32 changedNodeTileCount = (u32)(std::unique(changedNodeTiles, changedNodeTiles + dirtyTileCount * 2, [](const Vec2i &a, const Vec2i &b) {
+					return a.x == b.x && a.y == b.y;
+				}) - changedNodeTiles);
+
+				// Merge the old nodes with the changed positions, so the nodes stays in the same raster order Reload() creates them.
+				// The closest nodes are pointers, so these are stored as old node indices until the new nodes are in place.
+				constexpr s32 NoNode = -1;
+				std::vector<PathNode> oldPath = std::move(enemyPath);
+				const u32 oldNodeCount = (u32)oldPath.size();
+				s32 *oldToNewNodes = mem::PushArray<s32>(&levelMemory, oldNodeCount, false, 16);
+				for (u32 nodeIndex = 0; nodeIndex < oldNodeCount; ++nodeIndex) {
+					oldToNewNodes[nodeIndex] = NoNode;
+				}
+				s32 *newToOldNodes = mem::PushArray<s32>(&levelMemory, oldNodeCount + changedNodeTileCount, false, 16);
+				Vec2f *changePositions = mem::PushArray<Vec2f>(&levelMemory, changedNodeTileCount + dirtyTileCount, false, 16);
+				u32 changePositionCount = 0;
+				enemyPath.clear();
+				u32 oldNodeIndex = 0;
+				u32 changedIndex = 0;
+				while (oldNodeIndex < oldPath.size() || changedIndex < changedNodeTileCount) {
+					bool takeOld = changedIndex == changedNodeTileCount || (oldNodeIndex < oldPath.size() && tileOrder(oldPath[oldNodeIndex].tilePosition, changedNodeTiles[changedIndex]));
+					if (takeOld) {
+						newToOldNodes[enemyPath.size()] = (s32)oldNodeIndex;
+						oldToNewNodes[oldNodeIndex] = (s32)enemyPath.size();
+						enemyPath.emplace_back(oldPath[oldNodeIndex]);
+						++oldNodeIndex;
+						continue;
+					}
+					const Vec2i &nodeTile = changedNodeTiles[changedIndex++];
+					bool hadNode = oldNodeIndex < oldPath.size() && oldPath[oldNodeIndex].tilePosition.x == nodeTile.x && oldPath[oldNodeIndex].tilePosition.y == nodeTile.y;
+					bool hasNode = IsPathNodeTile(nodeTile.x, nodeTile.y);
+					if (hadNode && hasNode) {
+						newToOldNodes[enemyPath.size()] = (s32)oldNodeIndex;
+						oldToNewNodes[oldNodeIndex] = (s32)enemyPath.size();
+						enemyPath.emplace_back(oldPath[oldNodeIndex]);
+					} else if (hasNode) {
+						PathNode node = {};
+						node.tilePosition = nodeTile;
+						node.worldPosition = TileToWorld(node.tilePosition.x, node.tilePosition.y);
+						newToOldNodes[enemyPath.size()] = NoNode;
+						enemyPath.emplace_back(node);
+						changePositions[changePositionCount++] = node.worldPosition;
+					} else if (hadNode) {
+						changePositions[changePositionCount++] = oldPath[oldNodeIndex].worldPosition;
+					}
+					if (hadNode) {
+						++oldNodeIndex;
+					}
+				}
+				for (u32 dirtyIndex = 0; dirtyIndex < dirtyTileCount; ++dirtyIndex) {
+					changePositions[changePositionCount++] = TileToWorld(dirtyTiles[dirtyIndex]);
+				}
+				dirtyTiles.clear();
+
+				// The search of a node only visits tiles and nodes up to the projection of its closest node,
+				// so it has to be computed again when anything has changed within that range.
+				// @NOTE: The margin covers every tile touched by the line casts, which may be half a tile beside the ray.
+				u32 *updateNodes = mem::PushArray<u32>(&levelMemory, enemyPath.size(), false, 16);
+				u32 updateNodeCount = 0;
+				for (u32 nodeIndex = 0; nodeIndex < enemyPath.size(); ++nodeIndex) {
+					PathNode &node = enemyPath[nodeIndex];
+					s32 oldIndex = newToOldNodes[nodeIndex];
+					bool needsUpdate = oldIndex == NoNode;
+					for (u32 dirIndex = 0; dirIndex < PATH_NODE_SEARCH_DIRECTION_COUNT && !needsUpdate; ++dirIndex) {
+						const Vec2f &searchDir = PATH_NODE_SEARCH_DIRECTIONS[dirIndex];
+						const PathNode *oldClosest = node.closestNodes[dirIndex];
+						f32 margin = (Absolute(searchDir.x) + Absolute(searchDir.y)) * TILE_SIZE;
+						f32 maxProj = F32_MAX;
+						if (oldClosest != nullptr) {
+							s32 oldClosestIndex = (s32)(oldClosest - &oldPath[0]);
+							if (oldToNewNodes[oldClosestIndex] == NoNode) {
+								needsUpdate = true;
+								break;
+							}
+							maxProj = Dot(searchDir, oldClosest->worldPosition - node.worldPosition) + margin;
+						}
+						for (u32 changeIndex = 0; changeIndex < changePositionCount; ++changeIndex) {
+							f32 proj = Dot(searchDir, changePositions[changeIndex] - node.worldPosition);
+							if (proj > -margin && proj <= maxProj) {
+								needsUpdate = true;
+								break;
+							}
+						}
+					}
+					if (needsUpdate) {
+						updateNodes[updateNodeCount++] = nodeIndex;
+					} else {
+						for (u32 dirIndex = 0; dirIndex < PATH_NODE_SEARCH_DIRECTION_COUNT; ++dirIndex) {
+							const PathNode *oldClosest = node.closestNodes[dirIndex];
+							if (oldClosest != nullptr) {
+								node.closestNodes[dirIndex] = &enemyPath[oldToNewNodes[oldClosest - &oldPath[0]]];
 							}
 						}
-
-						assert(dirIndex < utils::ArrayCount(targetNode.closestNodes));
-						targetNode.closestNodes[dirIndex] = closestNode;
-
 					}
-
 				}
+				UpdateClosestNodes(updateNodes, updateNodeCount);
+
+				mem::EndTemporaryMemory(&tempMemory);
 			}
 
 			void Game::UISaveMap(const bool withDialog) {
@@ -828,7 +1472,9 @@ namespace fs {
 			}
 
 			void Game::HandleInput(const Input &input) {
-				renderer->Update(HALF_GAME_WIDTH, HALF_GAME_HEIGHT, GAME_ASPECT);
+				// The whole map is visible, so the view changes with the map size
+				const Vec2f tileMapExt = GetTileMapExt();
+				renderer->Update(tileMapExt.w, tileMapExt.h, tileMapExt.w / tileMapExt.h);
 
 				// Update world mouse position
 				const s32 mouseX = input.mouse.pos.x;
@@ -841,7 +1487,7 @@ namespace fs {
 
 				if (input.keyboard.editorToggle.WasPressed()) {
 					if (isEditor) {
-						Reload();
+						ReloadDirtyTiles();
 					}
 					isEditor = !isEditor;
 				}
@@ -867,8 +1513,7 @@ namespace fs {
 					SetExternalForces();
 					ProcessPlayerInput(input);
 					ProcessEnemyAI(input.deltaTime);
-					MoveEntities(players, input.deltaTime);
-					MoveEntities(enemies, input.deltaTime);
+					UpdateEntities(input.deltaTime);
 				} else {
 
 				}
@@ -878,19 +1523,16 @@ namespace fs {
 			LineCastResult Game::DoLineCast(const Ray2D &ray) {
 				LineCastResult result = {};
 
-				std::vector<Vec2i> lineTiles;
-				Vec2i startTilePos = WorldToTile(ray.start);
-				Vec2i endTilePos = WorldToTile(ray.end);
-				BresenhamLine(startTilePos.x, startTilePos.y, endTilePos.x, endTilePos.y, 1.0f, lineTiles);
+				// @NOTE: Tiles are visited in order along the ray, so the first hit is always the nearest one
+				const Vec2f tileMapExt = GetTileMapExt();
+				GridTraversal2D traversal = BeginGridTraversal(ray.start, ray.end, -tileMapExt, TILE_SIZE);
 
 				result.tMin = 1.0f;
-				for (Vec2i lineTile : lineTiles) {
+				Vec2i lineTile;
+				while (NextGridCell(traversal, lineTile)) {
 					if (IsSolid(lineTile)) {
-						Vec2f tilePos = TileToWorld(lineTile);
-						Vec2f rel = ray.start - tilePos;
-
 						Quad quad = {};
-						quad.center = tilePos;
+						quad.center = TileToWorld(lineTile);
 						quad.ext = TILE_EXT;
 
 						LineCastResult castResult = LineCastQuad(ray, quad);
@@ -898,6 +1540,7 @@ namespace fs {
 							result.isHit = true;
 							result.tMin = castResult.tMin;
 							result.surfaceNormal = castResult.surfaceNormal;
+							break;
 						}
 					}
 				}
@@ -905,49 +1548,100 @@ namespace fs {
 				return(result);
 			}
 
-			void Game::Render(const Input &input) {
-				renderer->BeginFrame();
+			size_t Game::GetSnapshotSize() const {
+				// @NOTE: Entities are only added in HandleInput(), so the snapshot never needs to grow while updating
+				size_t result = sizeof(GameSnapshot) + sizeof(EntitySnapshot) * (players.GetSlotCount() + enemies.GetSlotCount());
+				return(result);
+			}
 
-			#if !TEST_ACTIVE
+			void Game::WriteSnapshot(void *snapshot) {
+				GameSnapshot *gameSnapshot = (GameSnapshot *)snapshot;
+				EntitySnapshot *entities = gameSnapshot->GetEntities();
+				u32 entityCount = 0;
 
-				if (!isEditor) {
-					// Draw walls
-					for (u32 wallIndex = 0; wallIndex < walls.size(); ++wallIndex) {
-						const Wall &wall = walls[wallIndex];
-						s32 tileTypeIndex = (s32)TileType::Block;
-						if (wall.isPlatform) {
-							tileTypeIndex = (s32)TileType::Platform;
-						}
-						Vec2f uvMax = TileUVs[tileTypeIndex * 2 + 0];
-						Vec2f uvMin = TileUVs[tileTypeIndex * 2 + 1];
-						renderer->DrawSprite(wall.position, wall.ext, Vec4f::White, tilesetTexture, uvMin, uvMax);
+				// Enemies first, so players are drawn on top
+				for (u32 enemySlot = 0; enemySlot < enemies.GetSlotCount(); ++enemySlot) {
+					if (!enemies.IsSlotUsed(enemySlot)) {
+						continue;
 					}
+					const Entity &enemy = enemies.GetSlot(enemySlot);
+					assert(enemy.type == Entity::Type::Enemy);
+					EntitySnapshot &entity = entities[entityCount++];
+					entity.previousPosition = entityStore.GetPreviousPosition(enemy.storeIndex);
+					entity.position = entityStore.GetPosition(enemy.storeIndex);
+					entity.ext = enemy.ext;
+					entity.color = enemy.color;
+				}
 
-					// Draw enemies
-					for (u32 enemyIndex = 0; enemyIndex < enemies.size(); ++enemyIndex) {
-						const Entity &enemy = enemies[enemyIndex];
-						assert(enemy.type == Entity::Type::Enemy);
-						renderer->DrawRectangle(enemy.position, enemy.ext, enemy.color);
+				for (u32 playerSlot = 0; playerSlot < players.GetSlotCount(); ++playerSlot) {
+					if (!players.IsSlotUsed(playerSlot)) {
+						continue;
 					}
+					const Entity &player = players.GetSlot(playerSlot);
+					assert(player.type == Entity::Type::Player);
+					EntitySnapshot &entity = entities[entityCount++];
+					entity.previousPosition = entityStore.GetPreviousPosition(player.storeIndex);
+					entity.position = entityStore.GetPosition(player.storeIndex);
+					entity.ext = player.ext;
+					entity.color = player.color;
+				}
 
-					// Draw players
-					for (u32 playerIndex = 0; playerIndex < players.size(); ++playerIndex) {
-						const Entity &player = players[playerIndex];
-						assert(player.type == Entity::Type::Player);
-						renderer->DrawRectangle(player.position, player.ext, player.color);
-					}
+				assert(entityCount <= players.GetSlotCount() + enemies.GetSlotCount());
+				gameSnapshot->entityCount = entityCount;
+			}
+
+			void Game::DrawSnapshot(const GameSnapshot *snapshot, const f32 alpha) {
+				if (isEditor) {
+					return;
+				}
 
-					// Draw path nodes
-					Vec2f nodeExt = Vec2f(TILE_SIZE * 0.15);
-					for (u32 nodeIndex = 0; nodeIndex < enemyPath.size(); ++nodeIndex) {
-						const PathNode &node = enemyPath[nodeIndex];
-						renderer->DrawRectangle(node.worldPosition, nodeExt, Vec4f::Blue);
+				// Draw walls, one draw per tile chunk
+				for (u32 chunkY = 0; chunkY < tileMap.chunkCountForHeight; ++chunkY) {
+					for (u32 chunkX = 0; chunkX < tileMap.chunkCountForWidth; ++chunkX) {
+						TileChunk &chunk = tileChunks[chunkY * tileMap.chunkCountForWidth + chunkX];
+						if (chunk.isDirty) {
+							BuildTileChunk(chunkX, chunkY);
+						}
+						if (chunk.vertices.size() > 0) {
+							renderer->DrawQuads(&chunk.vertices[0], (u32)chunk.vertices.size(), tilesetTexture);
+						}
 					}
 				}
+
+				// Draw enemies and players
+				const EntitySnapshot *entities = snapshot->GetEntities();
+				for (u32 entityIndex = 0; entityIndex < snapshot->entityCount; ++entityIndex) {
+					const EntitySnapshot &entity = entities[entityIndex];
+					Vec2f position = Lerp(entity.previousPosition, alpha, entity.position);
+					renderer->DrawRectangle(position, entity.ext, entity.color);
+				}
+
+				// Draw path nodes
+				Vec2f nodeExt = Vec2f(TILE_SIZE * 0.15);
+				for (u32 nodeIndex = 0; nodeIndex < enemyPath.size(); ++nodeIndex) {
+					const PathNode &node = enemyPath[nodeIndex];
+					renderer->DrawRectangle(node.worldPosition, nodeExt, Vec4f::Blue);
+				}
+			}
+
+			void Game::RenderSnapshot(const Input &input, const void *snapshot, const f32 alpha) {
+				renderer->BeginFrame();
+				DrawSnapshot((const GameSnapshot *)snapshot, alpha);
+				renderer->EndFrame();
+			}
+
+			void Game::Render(const Input &input, const f32 alpha) {
+				renderer->BeginFrame();
+
+			#if !TEST_ACTIVE
+				// @NOTE: Goes through a snapshot as well, so rendering is the same with or without the simulation thread
+				GameSnapshot *snapshot = mem::PushSize<GameSnapshot>(frameMemory, GetSnapshotSize(), false, 16);
+				WriteSnapshot(snapshot);
+				DrawSnapshot(snapshot, alpha);
 			#else
 			#	if TEST_RAYCASTS
-				for (u32 y = 0; y < TILE_COUNT_FOR_HEIGHT; ++y) {
-					for (u32 x = 0; x < TILE_COUNT_FOR_WIDTH; ++x) {
+				for (u32 y = 0; y < tileMap.height; ++y) {
+					for (u32 x = 0; x < tileMap.width; ++x) {
 						const Tile &tile = GetTile(x, y);
 						if (tile.type == TileType::Block || tile.type == TileType::Platform) {
 							Vec2f p = TileToWorld(x, y);
@@ -1018,6 +1712,8 @@ namespace fs {
 				}
 
 			Game::Game() : BaseGame() {
+				players.Init(MAX_PLAYER_COUNT);
+				ResizeMap(DEFAULT_TILE_COUNT_FOR_WIDTH, DEFAULT_TILE_COUNT_FOR_HEIGHT);
 			}
 
 			Game::~Game() {
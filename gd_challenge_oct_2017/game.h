@@ -15,6 +15,8 @@
 #include "final_game.h"
 #include "final_randoms.h"
 #include "final_collisions.h"
+#include "final_mem.h"
+#include "final_pool.h"
 
 using namespace fs::maths;
 using namespace fs::inputs;
@@ -32,11 +34,18 @@ namespace fs {
 			constexpr f32 VecEqualTolerance = 0.001f;
 			constexpr f32 EntityPlaceOffset = 0.1f;
 
-			struct Wall;
+			typedef mem::PoolHandle PlayerHandle;
+			typedef mem::PoolHandle EnemyHandle;
+			typedef mem::PoolHandle WallHandle;
+
+			// One player for each controller
+			constexpr u32 MAX_PLAYER_COUNT = 5;
+			// Number of entity store blocks (four entities each) per parallel update batch
+			constexpr u32 ENTITY_UPDATE_BATCH_SIZE = 16;
 
 			struct CollisionState {
 				Vec2f normal;
-				Wall *wall;
+				WallHandle wall;
 				b32 isColliding;
 			};
 
@@ -74,6 +83,7 @@ namespace fs {
 				f32 dice;
 			};
 
+			// @NOTE: Position, velocity, acceleration and drag are stored in the EntityStore at the store index
 			struct Entity {
 				enum class Type {
 					None = 0,
@@ -82,21 +92,133 @@ namespace fs {
 				};
 
 				Vec4f color = Vec4f();
-				Vec2f position = Vec2f();
-				Vec2f velocity = Vec2f();
-				Vec2f acceleration = Vec2f();
 				Vec2f ext = Vec2f();
 				Vec2f moveDirection = Vec2f();
 				Type type = Type::None;
 				b32 isGrounded = false;
 				f32 horizontalSpeed = 0.0f;
-				f32 horizontalDrag = 0.0f;
 				b32 canJump = false;
 				u32 jumpCount = 0;
 				f32 jumpPower = 0.0f;
 				CollisionState collisions[4] = {};
 				u32 collisionCount;
 				AIState ai = {};
+				u32 storeIndex = 0;
+			};
+
+			// Kinematic data of all entities in SoA layout, so the forces and the integration can run on four entities at once.
+			// Players are stored first and the enemies after, the index of an entity is fixed by its pool slot.
+			struct EntityStore {
+				mem::MemoryBlock memory = {};
+				f32 *positionX = nullptr;
+				f32 *positionY = nullptr;
+				// Position before the last update step, used for interpolating between two steps while rendering
+				f32 *previousPositionX = nullptr;
+				f32 *previousPositionY = nullptr;
+				f32 *velocityX = nullptr;
+				f32 *velocityY = nullptr;
+				f32 *accelerationX = nullptr;
+				f32 *accelerationY = nullptr;
+				// Movement of the last integration, which is applied by the collision sweeps
+				f32 *movementX = nullptr;
+				f32 *movementY = nullptr;
+				f32 *horizontalDrag = nullptr;
+				// One for used entities and zero for unused entities, so unused entities never gets any force
+				f32 *activeMask = nullptr;
+				// Always a multiple of four
+				u32 capacity = 0;
+
+				inline void Init(const u32 entityCount) {
+					assert(memory.base == nullptr);
+					capacity = (entityCount + 3) & ~3;
+					memory = mem::AllocateMemoryBlock((capacity * sizeof(f32) + 16) * 12);
+					positionX = mem::PushArray<f32>(&memory, capacity, true, 16);
+					positionY = mem::PushArray<f32>(&memory, capacity, true, 16);
+					previousPositionX = mem::PushArray<f32>(&memory, capacity, true, 16);
+					previousPositionY = mem::PushArray<f32>(&memory, capacity, true, 16);
+					velocityX = mem::PushArray<f32>(&memory, capacity, true, 16);
+					velocityY = mem::PushArray<f32>(&memory, capacity, true, 16);
+					accelerationX = mem::PushArray<f32>(&memory, capacity, true, 16);
+					accelerationY = mem::PushArray<f32>(&memory, capacity, true, 16);
+					movementX = mem::PushArray<f32>(&memory, capacity, true, 16);
+					movementY = mem::PushArray<f32>(&memory, capacity, true, 16);
+					horizontalDrag = mem::PushArray<f32>(&memory, capacity, true, 16);
+					activeMask = mem::PushArray<f32>(&memory, capacity, true, 16);
+				}
+
+				inline void Release() {
+					if (memory.base != nullptr) {
+						mem::ReleaseMemoryBlock(&memory);
+					}
+					*this = EntityStore();
+				}
+
+				inline void Activate(const u32 index, const Vec2f &position, const f32 drag) {
+					assert(index < capacity);
+					Deactivate(index);
+					positionX[index] = previousPositionX[index] = position.x;
+					positionY[index] = previousPositionY[index] = position.y;
+					horizontalDrag[index] = drag;
+					activeMask[index] = 1.0f;
+				}
+
+				inline void Deactivate(const u32 index) {
+					assert(index < capacity);
+					positionX[index] = positionY[index] = 0.0f;
+					previousPositionX[index] = previousPositionY[index] = 0.0f;
+					velocityX[index] = velocityY[index] = 0.0f;
+					accelerationX[index] = accelerationY[index] = 0.0f;
+					movementX[index] = movementY[index] = 0.0f;
+					horizontalDrag[index] = 0.0f;
+					activeMask[index] = 0.0f;
+				}
+
+				inline Vec2f GetPosition(const u32 index) const {
+					Vec2f result = Vec2f(positionX[index], positionY[index]);
+					return(result);
+				}
+				inline Vec2f GetPreviousPosition(const u32 index) const {
+					Vec2f result = Vec2f(previousPositionX[index], previousPositionY[index]);
+					return(result);
+				}
+				inline void SetPosition(const u32 index, const Vec2f &position) {
+					positionX[index] = position.x;
+					positionY[index] = position.y;
+				}
+				inline Vec2f GetVelocity(const u32 index) const {
+					Vec2f result = Vec2f(velocityX[index], velocityY[index]);
+					return(result);
+				}
+				inline void SetVelocity(const u32 index, const Vec2f &velocity) {
+					velocityX[index] = velocity.x;
+					velocityY[index] = velocity.y;
+				}
+				inline void AddAcceleration(const u32 index, const Vec2f &acceleration) {
+					accelerationX[index] += acceleration.x;
+					accelerationY[index] += acceleration.y;
+				}
+			};
+
+			// Render state of a single player or enemy
+			struct EntitySnapshot {
+				Vec2f previousPosition;
+				Vec2f position;
+				Vec2f ext;
+				Vec4f color;
+			};
+
+			// Everything which is changed in Update() and needed for rendering, the entities are stored right behind it.
+			// @NOTE: Tiles, tile chunks and path nodes are only changed in HandleInput(), so these are not part of the snapshot.
+			struct GameSnapshot {
+				u32 entityCount;
+				u32 padding[3];
+
+				inline EntitySnapshot *GetEntities() {
+					return (EntitySnapshot *)(this + 1);
+				}
+				inline const EntitySnapshot *GetEntities() const {
+					return (const EntitySnapshot *)(this + 1);
+				}
 			};
 
 			enum class TileType : s32 {
@@ -113,10 +235,11 @@ namespace fs {
 				TileType tileType = TileType::None;
 				Vec2f position = {};
 				Vec2f ext = {};
+				Vec2i tilePosition = {};
 			};
 
 			struct ControlledPlayer {
-				u32 playerIndex = 0;
+				PlayerHandle playerHandle = {};
 				u32 controllerIndex = 0;
 			};
 
@@ -147,6 +270,12 @@ namespace fs {
 				TileType type = TileType::None;
 			};
 
+			// Cached render geometry for a block of tiles, rebuilt only when a tile inside has changed
+			struct TileChunk {
+				std::vector<RenderVertex> vertices = std::vector<RenderVertex>();
+				b32 isDirty = true;
+			};
+
 			struct ResultTilePosition {
 				b32 found;
 				s32 tileX;
@@ -154,23 +283,90 @@ namespace fs {
 			};
 
 			static constexpr f32 TILE_SIZE = 0.5f;
-			static constexpr u32 TILE_COUNT_FOR_WIDTH = 40;
-			static constexpr u32 TILE_COUNT_FOR_HEIGHT = 22;
-			static constexpr f32 GAME_ASPECT = TILE_COUNT_FOR_WIDTH / (f32)TILE_COUNT_FOR_HEIGHT;
-			static constexpr f32 GAME_WIDTH = TILE_COUNT_FOR_WIDTH * TILE_SIZE;
-			static constexpr f32 GAME_HEIGHT = GAME_WIDTH / GAME_ASPECT;
-			static constexpr f32 HALF_GAME_WIDTH = GAME_WIDTH * 0.5f;
-			static constexpr f32 HALF_GAME_HEIGHT = GAME_HEIGHT * 0.5f;
+			// Size of a new map, loaded maps have the size stored in the map file
+			static constexpr u32 DEFAULT_TILE_COUNT_FOR_WIDTH = 40;
+			static constexpr u32 DEFAULT_TILE_COUNT_FOR_HEIGHT = 22;
+			// Limits for the map size, keeps the tile count and the level memory of corrupt or huge map files in range
+			static constexpr u32 MAX_TILE_COUNT_FOR_WIDTH = 1024;
+			static constexpr u32 MAX_TILE_COUNT_FOR_HEIGHT = 1024;
+			static constexpr u64 MAX_TILE_COUNT = (u64)MAX_TILE_COUNT_FOR_WIDTH * MAX_TILE_COUNT_FOR_HEIGHT;
 			static constexpr char MAP_MAGIC_ID[4] = { 'f', 'm', 'a', 'p' };
+			static constexpr u32 MAP_FILE_VERSION = 2;
+			static constexpr u32 MAP_FILE_CHUNK_SIZE = 32;
+			static constexpr u32 TILE_CHUNK_SHIFT = 3;
+			static constexpr u32 TILE_CHUNK_SIZE = 1 << TILE_CHUNK_SHIFT;
+			// Level memory per tile, enough for the path node scratch memory of Reload() and ReloadDirtyTiles()
+			static constexpr size_t LEVEL_MEMORY_SIZE_PER_TILE = 160;
+			static constexpr size_t LEVEL_MEMORY_BASE_SIZE = 4096;
+			// A chunk has exactly one bit per tile in the tile map masks
+			static_assert(TILE_CHUNK_SIZE * TILE_CHUNK_SIZE == 64, "Tile chunk must have 64 tiles");
 
 			static const Vec2f TILE_EXT = Vec2f(TILE_SIZE, TILE_SIZE) * 0.5f;
 
-			typedef u32 PlayerIndex;
-			typedef u32 EnemyIndex;
+			// Runtime sized tile map.
+			// @NOTE: Tiles are stored in chunks of 8x8 tiles instead of rows, so the neighbours of a tile are mostly in the same cache lines.
+			// These are the same chunks as the render chunks, so all tiles of a chunk are stored next to each other.
+			struct TileMap {
+				std::vector<Tile> tiles = std::vector<Tile>();
+				// One bit per tile for each chunk, the bit index is the tile index inside the chunk
+				std::vector<u64> solidMasks = std::vector<u64>();
+				std::vector<u64> platformMasks = std::vector<u64>();
+				u32 width = 0;
+				u32 height = 0;
+				u32 chunkCountForWidth = 0;
+				u32 chunkCountForHeight = 0;
+
+				inline void Resize(const u32 newWidth, const u32 newHeight) {
+					width = newWidth;
+					height = newHeight;
+					chunkCountForWidth = (width + TILE_CHUNK_SIZE - 1) / TILE_CHUNK_SIZE;
+					chunkCountForHeight = (height + TILE_CHUNK_SIZE - 1) / TILE_CHUNK_SIZE;
+					tiles.assign(chunkCountForWidth * chunkCountForHeight * TILE_CHUNK_SIZE * TILE_CHUNK_SIZE, Tile());
+					solidMasks.assign(chunkCountForWidth * chunkCountForHeight, 0);
+					platformMasks.assign(chunkCountForWidth * chunkCountForHeight, 0);
+				}
+
+				inline void Clear() {
+					Resize(width, height);
+				}
+
+				inline u32 GetChunkIndex(const u32 x, const u32 y) const {
+					u32 result = (y >> TILE_CHUNK_SHIFT) * chunkCountForWidth + (x >> TILE_CHUNK_SHIFT);
+					return(result);
+				}
+
+				inline u32 GetTileIndex(const u32 x, const u32 y) const {
+					assert(x < width && y < height);
+					u32 result = (GetChunkIndex(x, y) << (TILE_CHUNK_SHIFT * 2)) | ((y & (TILE_CHUNK_SIZE - 1)) << TILE_CHUNK_SHIFT) | (x & (TILE_CHUNK_SIZE - 1));
+					return(result);
+				}
+
+				inline void SetTileType(const u32 x, const u32 y, const TileType type) {
+					u32 index = GetTileIndex(x, y);
+					tiles[index].type = type;
+					u32 chunkIndex = index >> (TILE_CHUNK_SHIFT * 2);
+					u64 tileBit = 1ULL << (index & (TILE_CHUNK_SIZE * TILE_CHUNK_SIZE - 1));
+					bool isPlatform = type == TileType::Platform;
+					bool isSolid = isPlatform || type == TileType::Block;
+					solidMasks[chunkIndex] = isSolid ? (solidMasks[chunkIndex] | tileBit) : (solidMasks[chunkIndex] & ~tileBit);
+					platformMasks[chunkIndex] = isPlatform ? (platformMasks[chunkIndex] | tileBit) : (platformMasks[chunkIndex] & ~tileBit);
+				}
+
+				inline bool IsSolid(const u32 x, const u32 y) const {
+					u32 index = GetTileIndex(x, y);
+					bool result = ((solidMasks[index >> (TILE_CHUNK_SHIFT * 2)] >> (index & (TILE_CHUNK_SIZE * TILE_CHUNK_SIZE - 1))) & 1) != 0;
+					return(result);
+				}
+			};
 
 			struct Game : BaseGame {
+				inline Vec2f GetTileMapExt() const {
+					Vec2f result = Vec2f((f32)tileMap.width * TILE_SIZE, (f32)tileMap.height * TILE_SIZE) * 0.5f;
+					return(result);
+				}
+
 				inline Vec2f TileToWorld(const s32 tileX, const s32 tileY) const {
-					const Vec2f tileMapExt = Vec2f((f32)TILE_COUNT_FOR_WIDTH * TILE_SIZE, (f32)TILE_COUNT_FOR_HEIGHT * TILE_SIZE) * 0.5f;
+					const Vec2f tileMapExt = GetTileMapExt();
 					Vec2f result = -tileMapExt +
 						Vec2f((f32)tileX, (f32)tileY) * TILE_SIZE +
 						TILE_SIZE * 0.5f;
@@ -182,7 +378,7 @@ namespace fs {
 				}
 
 				inline Vec2i WorldToTile(const f32 worldX, const f32 worldY) const {
-					const Vec2f tileMapExt = Vec2f((f32)TILE_COUNT_FOR_WIDTH * TILE_SIZE, (f32)TILE_COUNT_FOR_HEIGHT * TILE_SIZE) * 0.5f;
+					const Vec2f tileMapExt = GetTileMapExt();
 					s32 tileX = (s32)((worldX + tileMapExt.w) / TILE_SIZE);
 					s32 tileY = (s32)((worldY + tileMapExt.h) / TILE_SIZE);
 					Vec2i result = Vec2i(tileX, tileY);
@@ -195,11 +391,7 @@ namespace fs {
 				}
 
 				inline bool IsSolid(const u32 tileX, const u32 tileY) {
-					bool result = false;
-					if (IsValidTilePosition(tileX, tileY)) {
-						const Tile &tile = GetTile(tileX, tileY);
-						result = (tile.type == TileType::Block) || (tile.type == TileType::Platform);
-					}
+					bool result = IsValidTilePosition(tileX, tileY) && tileMap.IsSolid(tileX, tileY);
 					return(result);
 				}
 				inline bool IsSolid(const Vec2i &tile) {
@@ -215,17 +407,26 @@ namespace fs {
 				bool firstTimeOpenDialog = false;
 
 				TileType selectedTileType = TileType::None;
+				Vec2i newMapSize = Vec2i(DEFAULT_TILE_COUNT_FOR_WIDTH, DEFAULT_TILE_COUNT_FOR_HEIGHT);
 
-				std::vector<Tile> tiles = std::vector<Tile>(TILE_COUNT_FOR_WIDTH * TILE_COUNT_FOR_HEIGHT);
+				TileMap tileMap = TileMap();
+				std::vector<TileChunk> tileChunks = std::vector<TileChunk>();
+				// Tiles changed since the last reload, walls and path nodes are only updated around these tiles
+				std::vector<Vec2i> dirtyTiles = std::vector<Vec2i>();
+				// The whole map was replaced, so nothing derived from it can be kept
+				bool isFullReloadRequired = false;
 
 				inline void SetTile(const u32 x, const u32 y, const TileType type) {
-					u32 index = y * TILE_COUNT_FOR_WIDTH + x;
-					assert(index < tiles.size());
-					tiles[index].type = type;
+					u32 index = tileMap.GetTileIndex(x, y);
+					if (tileMap.tiles[index].type != type) {
+						tileMap.SetTileType(x, y, type);
+						tileChunks[tileMap.GetChunkIndex(x, y)].isDirty = true;
+						dirtyTiles.push_back(Vec2i(x, y));
+					}
 				}
 
 				inline bool IsValidTilePosition(const s32 x, const s32 y) {
-					bool result = (x >= 0 && x < TILE_COUNT_FOR_WIDTH) && (y >= 0 && y < TILE_COUNT_FOR_HEIGHT);
+					bool result = (x >= 0 && x < (s32)tileMap.width) && (y >= 0 && y < (s32)tileMap.height);
 					return(result);
 				}
 
@@ -235,8 +436,8 @@ namespace fs {
 				}
 
 				inline const Tile &GetTile(const u32 x, const u32 y) const {
-					u32 index = y * TILE_COUNT_FOR_WIDTH + x;
-					return(tiles[index]);
+					u32 index = tileMap.GetTileIndex(x, y);
+					return(tileMap.tiles[index]);
 				}
 
 				inline const Tile &GetTile(const Vec2i &xy) const {
@@ -245,8 +446,14 @@ namespace fs {
 				}
 
 				inline TileType GetTileType(const u32 x, const u32 y) const {
-					u32 index = y * TILE_COUNT_FOR_WIDTH + x;
-					return(tiles[index].type);
+					u32 index = tileMap.GetTileIndex(x, y);
+					return(tileMap.tiles[index].type);
+				}
+
+				// There is at most one path node per tile, so the tile count limits the level memory
+				inline size_t GetLevelMemorySize() const {
+					size_t result = (size_t)tileMap.width * tileMap.height * LEVEL_MEMORY_SIZE_PER_TILE + LEVEL_MEMORY_BASE_SIZE;
+					return(result);
 				}
 
 				Vec2f gravity = Vec2f(0, -4);
@@ -255,11 +462,18 @@ namespace fs {
 
 				bool isEditor = false;
 
-				std::vector<Entity> players = std::vector<Entity>();
-				std::vector<Entity> enemies = std::vector<Entity>();
-				std::vector<Wall> walls = std::vector<Wall>();
+				// @NOTE: Entities and walls are stored in fixed size pools, so there is no reallocation while playing.
+				// Enemies and walls are limited by the tile count and the pools are only created again when the map is resized.
+				mem::Pool<Entity> players;
+				mem::Pool<Entity> enemies;
+				mem::Pool<Wall> walls;
+				EntityStore entityStore;
+				// Wall handle for each tile or a zero handle, used as a broadphase for the collision sweeps
+				std::vector<WallHandle> wallTileHandles = std::vector<WallHandle>();
 				std::vector<PathNode> enemyPath = std::vector<PathNode>();
 				std::vector<ControlledPlayer> controlledPlayers = std::vector<ControlledPlayer>();
+				// Scratch memory for rebuilding the level, cleared on each full reload
+				mem::MemoryBlock levelMemory = {};
 
 				Texture tilesetTexture = {};
 
@@ -276,25 +490,70 @@ namespace fs {
 
 				ResultTilePosition FindFreePlayerTile();
 
-				EnemyIndex CreateEnemy(u32 tileX, u32 tileY);
+				EnemyHandle CreateEnemy(u32 tileX, u32 tileY);
+
+				PlayerHandle CreatePlayer(const u32 controllerIndex);
+
+				// Removes all entities from the pool and from the entity store
+				void ClearEntities(mem::Pool<Entity> &entities);
+
+				// Number of entities to process in the entity store, players and all used enemy slots rounded up to four
+				inline u32 GetEntityStoreCount() const {
+					u32 result = (MAX_PLAYER_COUNT + enemies.GetSlotCount() + 3) & ~3;
+					assert(result <= entityStore.capacity);
+					return(result);
+				}
 
-				PlayerIndex CreatePlayer(const u32 controllerIndex);
+				// Player or enemy for the given entity store index or null when the index is not used
+				inline Entity *GetStoreEntity(const u32 storeIndex) {
+					Entity *result = nullptr;
+					if (storeIndex < MAX_PLAYER_COUNT) {
+						if (storeIndex < players.GetSlotCount() && players.IsSlotUsed(storeIndex)) {
+							result = &players.GetSlot(storeIndex);
+						}
+					} else {
+						u32 enemySlot = storeIndex - MAX_PLAYER_COUNT;
+						if (enemySlot < enemies.GetSlotCount() && enemies.IsSlotUsed(enemySlot)) {
+							result = &enemies.GetSlot(enemySlot);
+						}
+					}
+					return(result);
+				}
 
 				s32 FindControlledPlayerIndex(const u32 controllerIndex);
 
 				void UISaveMap(const bool withDialog);
 
 				void ClearMap();
+				// Changes the map size and clears the map
+				void ResizeMap(const u32 width, const u32 height);
 				bool LoadMap(const char *filePath);
 				void SaveMap(const char *filePath);
 				void Reload();
+				// Same as Reload(), but only the walls and path nodes around the dirty tiles are created again
+				void ReloadDirtyTiles();
+				void CreateEnemies();
+				bool IsPathNodeTile(const s32 x, const s32 y);
+				// Computes the closest nodes for the given path nodes or for all nodes when null
+				void UpdateClosestNodes(const u32 *nodeIndices, const u32 nodeIndexCount);
+
+				void ClearWallTileHandles();
+				void InvalidateTileChunks();
+				void BuildTileChunk(const u32 chunkX, const u32 chunkY);
 
 				void HandleControllerConnections(const Input &input);
 				void ProcessPlayerInput(const Input &input);
 				void ProcessEnemyAI(const f32 deltaTime);
-				void MoveEntities(std::vector<Entity> &entities, const f32 deltaTime);
+				// Integrates the entity store entries from startIndex up to endIndex, both must be a multiple of four
+				void IntegrateEntities(const u32 startIndex, const u32 endIndex, const f32 deltaTime);
+				// Sweeps the entity against the walls and applies the collision response
+				void MoveEntity(Entity &entity);
+				// Integrates and moves all players and enemies, blocks of entities are processed in parallel on the worker pool
+				void UpdateEntities(const f32 deltaTime);
 				void SetExternalForces();
 				void EditorUpdate();
+				// Draws the tiles, the interpolated entities and the path nodes, without beginning or ending the frame
+				void DrawSnapshot(const GameSnapshot *snapshot, const f32 alpha);
 			public:
 				Game();
 				~Game() override;
@@ -302,7 +561,10 @@ namespace fs {
 				void Release() override;
 				void HandleInput(const Input &input) override;
 				void Update(const Input &input) override;
-				void Render(const Input &input) override;
+				void Render(const Input &input, const f32 alpha) override;
+				size_t GetSnapshotSize() const override;
+				void WriteSnapshot(void *snapshot) override;
+				void RenderSnapshot(const Input &input, const void *snapshot, const f32 alpha) override;
 
 			};
 
@@ -1,9 +1,38 @@
 #define FPL_IMPLEMENTATION
 #include <final_platform_layer.hpp>
+#include <string.h>
+#include <stdlib.h>
+
 #include "game.h"
+#include "final_tiletrace.h"
 
 int main(int argc, char **args) {
+	if (argc > 1 && strcmp(args[1], "-queuebenchmark") == 0) {
+		fs::concurrency::RunConcurrentQueueBenchmark(fpl::hardware::GetProcessorCoreCount(), 1000000);
+		return 0;
+	}
+	if (argc > 1 && strcmp(args[1], "-tracebenchmark") == 0) {
+		fs::tiletracer::RunTileTraceBenchmark(512, 10);
+		return 0;
+	}
+	if (argc > 2 && strcmp(args[1], "-headless") == 0) {
+		fs::games::BaseGame *game = new fs::games::mygame::Game();
+		fs::games::RunGameHeadless(game, 1280, 720, (fs::u32)atoi(args[2]));
+		delete game;
+		return 0;
+	}
+	if (argc > 2 && strcmp(args[1], "-replay") == 0) {
+		fs::games::ReplayRecordedFrame(args[2], 100);
+		return 0;
+	}
+	if (argc > 2 && strcmp(args[1], "-record") == 0) {
+		fs::games::BaseGame *game = new fs::games::mygame::Game();
+		fs::games::RunGameHeadless(game, 1280, 720, 60, args[2]);
+		delete game;
+		return 0;
+	}
+	bool useSimulationThread = (argc > 1 && strcmp(args[1], "-simthread") == 0);
 	fs::games::BaseGame *game = new fs::games::mygame::Game();
-	fs::games::RunGame(game);
+	fs::games::RunGame(game, useSimulationThread);
 	delete game;
 }
\ No newline at end of file